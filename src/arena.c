@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "./include/arena.h"
+
+#define ALIGN_UP(n) (((n) + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1))
+
+// ----------------------------------------
+// FUNCTIONS
+
+// Allocates the whole block up-front. This is the only allocation an
+// arena ever does.
+int arena_init(Arena *a, size_t capacity) {
+  a->capacity = ALIGN_UP(capacity);
+  a->used = 0;
+  a->base = aligned_alloc(ARENA_ALIGNMENT, a->capacity);
+
+  if (!a->base) {
+    fprintf(stderr, "[ERROR] - Could not allocate arena of %zu bytes\n", capacity);
+    a->capacity = 0;
+    return 0;
+  }
+
+  return 1;
+}
+
+// Returns `size` bytes, or NULL if the arena is full. Memory is not
+// cleared, so that carving stays O(1).
+void *arena_alloc(Arena *a, size_t size) {
+  size = ALIGN_UP(size);
+  if (size > a->capacity - a->used) {
+    return NULL;
+  }
+
+  void *p = a->base + a->used;
+  a->used += size;
+
+  return p;
+}
+
+// Forgets every object carved so far, the memory itself is kept.
+void arena_reset(Arena *a) {
+  a->used = 0;
+}
+
+void arena_destroy(Arena *a) {
+  free(a->base);
+  a->base = NULL;
+  a->capacity = 0;
+  a->used = 0;
+}
@@ -0,0 +1,253 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+#include "./include/batch.h"
+
+typedef struct {
+  PackedMove *moves;
+  size_t count;
+  size_t capacity;
+
+  // set if the moves could not be allocated.
+  int failed;
+} ChunkResult;
+
+// chunks [next, end) still owned by a worker.
+typedef struct {
+  pthread_mutex_t lock;
+  size_t next;
+  size_t end;
+} WorkQueue;
+
+typedef struct {
+  const PosRecord *positions;
+  size_t positions_count;
+
+  // moves count of position i is stored in counts[i]
+  size_t *counts;
+  ChunkResult *chunks;
+
+  WorkQueue queues[BATCH_MAX_THREADS];
+  int threads;
+} BatchJob;
+
+typedef struct {
+  BatchJob *job;
+  int id;
+} Worker;
+
+// ----------------------------------------
+// FUNCTIONS
+
+// Takes the next chunk of worker `id`, stealing half of the chunks
+// left to another worker when its own queue is empty.
+//
+// Returns 0 once there is nothing left to do.
+static int take_chunk(BatchJob *job, int id, size_t *chunk) {
+  WorkQueue *own = &job->queues[id];
+
+  pthread_mutex_lock(&own->lock);
+  if (own->next < own->end) {
+    *chunk = own->next++;
+    pthread_mutex_unlock(&own->lock);
+    return 1;
+  }
+  pthread_mutex_unlock(&own->lock);
+
+  for (int i = 1; i < job->threads; i++) {
+    WorkQueue *victim = &job->queues[(id + i) % job->threads];
+
+    pthread_mutex_lock(&victim->lock);
+    size_t left = victim->end - victim->next;
+    if (left == 0) {
+      pthread_mutex_unlock(&victim->lock);
+      continue;
+    }
+
+    size_t end = victim->end;
+    size_t start = end - (left + 1) / 2;
+    victim->end = start;
+    pthread_mutex_unlock(&victim->lock);
+
+    pthread_mutex_lock(&own->lock);
+    own->next = start + 1;
+    own->end = end;
+    pthread_mutex_unlock(&own->lock);
+
+    *chunk = start;
+    return 1;
+  }
+
+  return 0;
+}
+
+static void process_chunk(BatchJob *job, size_t chunk, Game *game) {
+  ChunkResult *r = &job->chunks[chunk];
+  size_t first = chunk * BATCH_CHUNK_SIZE;
+  size_t last = first + BATCH_CHUNK_SIZE;
+  if (last > job->positions_count) {
+    last = job->positions_count;
+  }
+
+  Move moves[MAX_MOVES];
+
+  for (size_t i = first; i < last; i++) {
+    record_load_board(&job->positions[i], game);
+    int count = generate_moves(game, moves, MAX_MOVES);
+
+    if (r->count + count > r->capacity) {
+      size_t capacity = r->capacity ? r->capacity * 2 : BATCH_CHUNK_SIZE * 32;
+      PackedMove *moves = realloc(r->moves, capacity * sizeof(PackedMove));
+      if (!moves) {
+	fprintf(stderr, "[ERROR] - Could not allocate moves of chunk %zu\n", chunk);
+	r->failed = 1;
+	return;
+      }
+      r->moves = moves;
+      r->capacity = capacity;
+    }
+
+    for (int j = 0; j < count; j++) {
+      r->moves[r->count++] = pack_move(moves[j].start, moves[j].end);
+    }
+    job->counts[i] = count;
+  }
+}
+
+static void *worker_loop(void *arg) {
+  Worker *w = arg;
+
+  // scratch board reused for every position of this worker
+  Game game = {0};
+
+  size_t chunk;
+  while (take_chunk(w->job, w->id, &chunk)) {
+    process_chunk(w->job, chunk, &game);
+  }
+
+  return NULL;
+}
+
+// Generates the moves of every position in `positions`, using
+// `threads` workers (or one per online CPU if `threads` <= 0).
+//
+// Returns 1 on success, 0 otherwise. On success `out` must be released
+// with batch_free().
+int batch_generate_moves(const PosRecord *positions, size_t count, int threads, MoveBatch *out) {
+  memset(out, 0, sizeof(*out));
+
+  if (threads <= 0) {
+    threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (threads < 1) {
+    threads = 1;
+  }
+  if (threads > BATCH_MAX_THREADS) {
+    threads = BATCH_MAX_THREADS;
+  }
+
+  size_t chunks_count = (count + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE;
+  if ((size_t) threads > chunks_count) {
+    threads = chunks_count ? (int) chunks_count : 1;
+  }
+
+  BatchJob *job = calloc(1, sizeof(BatchJob));
+  out->offsets = calloc(count + 1, sizeof(size_t));
+  if (!job || !out->offsets) {
+    free(job);
+    free(out->offsets);
+    out->offsets = NULL;
+    return 0;
+  }
+
+  job->positions = positions;
+  job->positions_count = count;
+  job->counts = out->offsets + 1;
+  job->chunks = calloc(chunks_count ? chunks_count : 1, sizeof(ChunkResult));
+  job->threads = threads;
+
+  if (!job->chunks) {
+    free(job);
+    free(out->offsets);
+    out->offsets = NULL;
+    return 0;
+  }
+
+  // even share of chunks for every worker
+  for (int i = 0; i < threads; i++) {
+    pthread_mutex_init(&job->queues[i].lock, NULL);
+    job->queues[i].next = chunks_count * i / threads;
+    job->queues[i].end = chunks_count * (i + 1) / threads;
+  }
+
+  Worker workers[BATCH_MAX_THREADS];
+  pthread_t tids[BATCH_MAX_THREADS];
+  int started[BATCH_MAX_THREADS] = {0};
+
+  // if a thread can not be started its chunks are simply stolen by
+  // the other workers, worker 0 at least.
+  for (int i = 1; i < threads; i++) {
+    workers[i] = (Worker) {.job = job, .id = i};
+    started[i] = pthread_create(&tids[i], NULL, worker_loop, &workers[i]) == 0;
+  }
+
+  // the calling thread is worker 0
+  workers[0] = (Worker) {.job = job, .id = 0};
+  worker_loop(&workers[0]);
+
+  for (int i = 1; i < threads; i++) {
+    if (started[i]) {
+      pthread_join(tids[i], NULL);
+    }
+  }
+
+  int failed = 0;
+  for (size_t c = 0; c < chunks_count; c++) {
+    failed |= job->chunks[c].failed;
+  }
+
+  // turn counts into offsets, then lay chunks one after the other
+  for (size_t i = 0; i < count; i++) {
+    out->offsets[i + 1] += out->offsets[i];
+  }
+
+  out->positions_count = count;
+  out->moves_count = out->offsets[count];
+  out->moves = failed ? NULL : malloc((out->moves_count ? out->moves_count : 1) * sizeof(PackedMove));
+
+  for (size_t c = 0; c < chunks_count; c++) {
+    ChunkResult *r = &job->chunks[c];
+    if (out->moves && r->count) {
+      memcpy(out->moves + out->offsets[c * BATCH_CHUNK_SIZE], r->moves, r->count * sizeof(PackedMove));
+    }
+    free(r->moves);
+  }
+
+  for (int i = 0; i < threads; i++) {
+    pthread_mutex_destroy(&job->queues[i].lock);
+  }
+  free(job->chunks);
+  free(job);
+
+  if (!out->moves) {
+    batch_free(out);
+    return 0;
+  }
+
+  return 1;
+}
+
+void batch_free(MoveBatch *batch) {
+  free(batch->moves);
+  free(batch->offsets);
+  memset(batch, 0, sizeof(*batch));
+}
@@ -0,0 +1,91 @@
+/*
+  Generates the moves of every position stored in a record file.
+
+    ./batchmoves [-j threads] [-p] positions.bin
+
+  The positions are taken straight from the mapped file. -p prints the
+  moves of every position, one line per position, otherwise only the
+  totals and the throughput are reported.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+#include "./include/batch.h"
+
+// ----------------------------------------
+
+int main(int argc, char **argv) {
+  int threads = 0, print = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "j:p")) != -1) {
+    switch (opt) {
+    case 'j': threads = atoi(optarg); break;
+    case 'p': print = 1; break;
+    default:
+      fprintf(stderr, "Usage: %s [-j threads] [-p] positions.bin\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (optind + 1 != argc) {
+    fprintf(stderr, "Usage: %s [-j threads] [-p] positions.bin\n", argv[0]);
+    return 1;
+  }
+
+  RecordReader r;
+  if (!record_reader_open(&r, argv[optind])) {
+    return 1;
+  }
+  if (r.kind != RECORD_KIND_POSITIONS) {
+    fprintf(stderr, "[ERROR] - %s does not contain positions\n", argv[optind]);
+    record_reader_close(&r);
+    return 1;
+  }
+
+  size_t count;
+  const PosRecord *positions = record_positions(&r, &count);
+  if (!positions) {
+    record_reader_close(&r);
+    return 1;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  MoveBatch batch;
+  if (!batch_generate_moves(positions, count, threads, &batch)) {
+    fprintf(stderr, "[ERROR] - Could not generate moves\n");
+    record_reader_close(&r);
+    return 1;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  if (print) {
+    for (size_t i = 0; i < count; i++) {
+      for (size_t j = batch.offsets[i]; j < batch.offsets[i + 1]; j++) {
+	char mv[5];
+	format_move((Move) {packed_move_start(batch.moves[j]), packed_move_end(batch.moves[j])}, mv);
+	printf("%s%s", mv, j + 1 < batch.offsets[i + 1] ? " " : "");
+      }
+      printf("\n");
+    }
+  }
+
+  fprintf(stderr, "%zu positions, %zu moves in %.3f s (%.0f positions/s)\n",
+	  count, batch.moves_count, elapsed, elapsed > 0 ? count / elapsed : 0.0);
+
+  batch_free(&batch);
+  record_reader_close(&r);
+  return 0;
+}
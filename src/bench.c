@@ -0,0 +1,369 @@
+/*
+  Micro-benchmarks of the hot paths, results are printed as JSON.
+
+    ./bench [-n samples] [-p positions] [-f filter]
+
+  Every benchmark goes over the same set of positions, taken from
+  random games played with a fixed seed, so that runs on the same
+  machine can be compared. A sample is one pass over all of them
+  (repeated until it takes at least BENCH_MIN_SAMPLE_NS), and its time
+  is divided by the number of operations done. For each benchmark the
+  min, median and 99th percentile of the samples are reported, in
+  nanoseconds per operation.
+
+  render_game is drawn on an offscreen surface with the SDL software
+  renderer, so no window nor display is needed. It loads the piece
+  images from ../assets, like the game does, so bench must be run
+  from this directory. -f only runs the benchmarks whose name
+  contains `filter`.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+#include "./include/engine.h"
+#include "./include/render.h"
+
+#define DEFAULT_SAMPLES 100
+#define DEFAULT_POSITIONS 64
+#define MAX_POSITIONS 1024
+#define BENCH_SEED 0x5EED
+#define BENCH_MIN_SAMPLE_NS 1000000
+
+typedef struct {
+  const char *name;
+  // optional, sets up what the benchmark needs outside of the timings.
+  void (*prepare)(void);
+  // runs once over every position, returns the number of operations.
+  long (*run)(void);
+} Benchmark;
+
+// ----------------------------------------
+// GLOBAL VARIABLES
+
+static Game POSITIONS[MAX_POSITIONS];
+static char FENS[MAX_POSITIONS][FEN_MAX_LEN];
+static int POSITIONS_COUNT = 0;
+
+static Move MOVES[MAX_POSITIONS][MAX_MOVES];
+static int MOVES_COUNT[MAX_POSITIONS];
+
+static SDL_Surface *SURFACE = NULL;
+static SDL_Renderer *RENDERER = NULL;
+
+// results go here, so that the compiler can not drop the work.
+static volatile long SINK = 0;
+
+// ----------------------------------------
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// xorshift64, so that positions do not depend on the libc rand().
+static uint64_t next_random(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// Plays random games until `count` positions have been collected, one
+// every few plies.
+static void collect_positions(int count) {
+  static Game game;
+  uint64_t state = BENCH_SEED;
+  Move moves[MAX_MOVES];
+
+  init_game(&game);
+
+  for (int ply = 0; POSITIONS_COUNT < count; ply++) {
+    int n = generate_moves(&game, moves, MAX_MOVES);
+    Move m = moves[next_random(&state) % (n ? n : 1)];
+
+    if (n == 0 || move_piece(&game, game.board[m.start.x][m.start.y], m.end) ||
+	check_draw(&game) != DRAW_NONE) {
+      init_game(&game);
+      continue;
+    }
+
+    if (ply % 3 == 0) {
+      PosRecord r;
+      record_from_game(&r, &game);
+      record_to_fen(&r, FENS[POSITIONS_COUNT], FEN_MAX_LEN);
+      record_to_game(&r, &POSITIONS[POSITIONS_COUNT]);
+      POSITIONS_COUNT++;
+    }
+  }
+}
+
+// ----------------------------------------
+// BENCHMARKS
+
+static long bench_check_move_validity(void) {
+  long ops = 0, valid = 0;
+
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    Game *game = &POSITIONS[i];
+
+    for (int p = 0; p < game->pieces_count; p++) {
+      Piece *piece = &game->pieces[p];
+
+      for (int y = 0; y < BOARD_HEIGHT; y++) {
+	for (int x = 0; x < BOARD_WIDTH; x++) {
+	  valid += check_move_validity(game, piece, (Pos) {x, y});
+	  ops++;
+	}
+      }
+    }
+  }
+
+  SINK += valid;
+  return ops;
+}
+
+static long bench_update_valid_moves(void) {
+  long ops = 0, valid = 0;
+
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    Game *game = &POSITIONS[i];
+
+    for (int p = 0; p < game->pieces_count; p++) {
+      game->selected_piece = &game->pieces[p];
+      update_valid_moves(game);
+      valid += game->valid_moves_count;
+      ops++;
+    }
+
+    game->selected_piece = NULL;
+    game->valid_moves_count = 0;
+  }
+
+  SINK += valid;
+  return ops;
+}
+
+static long bench_generate_moves(void) {
+  Move moves[MAX_MOVES];
+  long count = 0;
+
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    count += generate_moves(&POSITIONS[i], moves, MAX_MOVES);
+  }
+
+  SINK += count;
+  return POSITIONS_COUNT;
+}
+
+static void prepare_make_unmake(void) {
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    MOVES_COUNT[i] = generate_moves(&POSITIONS[i], MOVES[i], MAX_MOVES);
+  }
+}
+
+static long bench_make_unmake(void) {
+  long ops = 0;
+
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    Game *game = &POSITIONS[i];
+
+    for (int j = 0; j < MOVES_COUNT[i]; j++) {
+      Undo u;
+      make_move(game, MOVES[i][j], &u);
+      unmake_move(game, &u);
+    }
+    ops += MOVES_COUNT[i];
+  }
+
+  SINK += POSITIONS[0].key;
+  return ops;
+}
+
+static long bench_evaluate(void) {
+  long score = 0;
+
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    score += evaluate(&POSITIONS[i]);
+  }
+
+  SINK += score;
+  return POSITIONS_COUNT;
+}
+
+static long bench_fen_to_record(void) {
+  PosRecord r;
+  long ok = 0;
+
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    ok += fen_to_record(FENS[i], &r);
+  }
+
+  SINK += ok;
+  return POSITIONS_COUNT;
+}
+
+// Selects a piece in every position, so that valid moves get drawn
+// too.
+static void prepare_render_game(void) {
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    Game *game = &POSITIONS[i];
+
+    for (int p = 0; p < game->pieces_count && !game->selected_piece; p++) {
+      if (OWNED_BY_PLAYER(game, (&game->pieces[p]))) {
+	update_selected_piece(game, game->pieces[p].pos);
+      }
+    }
+  }
+}
+
+static long bench_render_game(void) {
+  for (int i = 0; i < POSITIONS_COUNT; i++) {
+    render_game(RENDERER, &POSITIONS[i]);
+  }
+
+  return POSITIONS_COUNT;
+}
+
+// NOTE: render_game must stay last, see main().
+static const Benchmark BENCHMARKS[] = {
+  {"check_move_validity", NULL, bench_check_move_validity},
+  {"update_valid_moves", NULL, bench_update_valid_moves},
+  {"generate_moves", NULL, bench_generate_moves},
+  {"make_unmake", prepare_make_unmake, bench_make_unmake},
+  {"evaluate", NULL, bench_evaluate},
+  {"fen_to_record", NULL, bench_fen_to_record},
+  {"render_game", prepare_render_game, bench_render_game},
+};
+
+#define BENCHMARKS_COUNT ((int) (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0])))
+
+// ----------------------------------------
+
+// Creates the renderer drawing on an offscreen surface.
+static int init_renderer(void) {
+  IMG_Init(IMG_INIT_PNG);
+
+  SURFACE = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_RGBA8888);
+  RENDERER = SURFACE ? SDL_CreateSoftwareRenderer(SURFACE) : NULL;
+  if (!RENDERER) {
+    fprintf(stderr, "[ERROR] - Could not create the software renderer: %s\n", SDL_GetError());
+    return 0;
+  }
+
+  return 1;
+}
+
+static void destroy_renderer(void) {
+  destroy_piece_textures();
+  if (RENDERER) {
+    SDL_DestroyRenderer(RENDERER);
+  }
+  if (SURFACE) {
+    SDL_FreeSurface(SURFACE);
+  }
+  IMG_Quit();
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+static void run_benchmark(const Benchmark *b, int samples, double *times, int last) {
+  if (b->prepare) {
+    b->prepare();
+  }
+
+  // warm up caches (and textures) first, and find out how many passes
+  // a sample needs to be long enough to be measured
+  uint64_t start = now_ns();
+  b->run();
+  uint64_t elapsed = now_ns() - start;
+  long passes = elapsed >= BENCH_MIN_SAMPLE_NS ? 1 : (long) (BENCH_MIN_SAMPLE_NS / (elapsed + 1)) + 1;
+
+  long ops = 0;
+  for (int s = 0; s < samples; s++) {
+    ops = 0;
+    start = now_ns();
+    for (long p = 0; p < passes; p++) {
+      ops += b->run();
+    }
+    times[s] = (double) (now_ns() - start) / (ops ? ops : 1);
+  }
+
+  qsort(times, samples, sizeof(double), compare_doubles);
+  int p99 = (int) (0.99 * (samples - 1) + 0.5);
+
+  printf("    {\"name\": \"%s\", \"unit\": \"ns/op\", \"samples\": %d, \"ops_per_sample\": %ld, "
+	 "\"min\": %.2f, \"median\": %.2f, \"p99\": %.2f}%s\n",
+	 b->name, samples, ops, times[0], times[samples / 2], times[p99], last ? "" : ",");
+}
+
+int main(int argc, char **argv) {
+  int samples = DEFAULT_SAMPLES, positions = DEFAULT_POSITIONS;
+  const char *filter = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:p:f:")) != -1) {
+    switch (opt) {
+    case 'n': samples = atoi(optarg); break;
+    case 'p': positions = atoi(optarg); break;
+    case 'f': filter = optarg; break;
+    default:
+      fprintf(stderr, "Usage: %s [-n samples] [-p positions] [-f filter]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (samples < 1 || positions < 1 || positions > MAX_POSITIONS) {
+    fprintf(stderr, "[ERROR] - samples must be positive and positions within 1 and %d\n", MAX_POSITIONS);
+    return 1;
+  }
+
+  collect_positions(positions);
+
+  int selected[BENCHMARKS_COUNT], selected_count = 0;
+  for (int i = 0; i < BENCHMARKS_COUNT; i++) {
+    if (!filter || strstr(BENCHMARKS[i].name, filter)) {
+      selected[selected_count++] = i;
+    }
+  }
+
+  // render_game is the only one needing SDL, and it is skipped if the
+  // renderer can not be created
+  int render = selected_count > 0 && !strcmp(BENCHMARKS[selected[selected_count - 1]].name, "render_game");
+  if (render && !init_renderer()) {
+    selected_count--;
+  }
+
+  double *times = malloc(samples * sizeof(double));
+  if (!times) {
+    return 1;
+  }
+
+  printf("{\n  \"positions\": %d,\n  \"seed\": %d,\n  \"benchmarks\": [\n", POSITIONS_COUNT, BENCH_SEED);
+  for (int i = 0; i < selected_count; i++) {
+    run_benchmark(&BENCHMARKS[selected[i]], samples, times, i == selected_count - 1);
+    fflush(stdout);
+  }
+  printf("  ]\n}\n");
+
+  if (render) {
+    destroy_renderer();
+  }
+  free(times);
+
+  return 0;
+}
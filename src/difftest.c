@@ -0,0 +1,489 @@
+/*
+  Differential tester for the move generator.
+
+    ./difftest [-n playouts] [-m max_plies] [-d depth] [-s seed] [-o repro.fen]
+    ./difftest -f repro.fen [-d depth]
+
+  Moves are generated both by generate_moves() and by a reference
+  generator written straight from the rules, which shares no code with
+  game.c. First the perft counts of DEFAULT_BOARD are checked against
+  known values, and check_draw() on a few positions, then random games
+  are played: in every position the
+  two move lists must be the same, and so must the perft counts up to
+  `depth` plies.
+
+  When they are not, the position is minimized, by removing pieces as
+  long as the generators still disagree, and written as a FEN to
+  repro.fen (difftest-repro.fen by default). -f replays such a file.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+
+#define DEFAULT_PLAYOUTS 1000
+#define DEFAULT_MAX_PLIES 200
+#define DEFAULT_DEPTH 2
+#define DEFAULT_REPRO_PATH "difftest-repro.fen"
+
+// perft of DEFAULT_BOARD (black to move), following the rules of this
+// game: no check, no castling, en-passant nor promotion, and double
+// pushes jump over pieces. This is why they differ from the usual
+// chess ones from perft(3).
+static const long START_PERFT[] = { 1, 20, 400, 8982, 201378 };
+#define START_PERFT_DEPTH 4
+
+// positions whose draw status is known. Bare kings next to each other
+// are not a draw, the side to move eats the other king.
+static const struct {
+  const char *fen;
+  DrawReason expected;
+} DRAW_CASES[] = {
+  {"8/8/8/8/8/8/8/kK6 w - - 0 1", DRAW_NONE},
+  {"8/8/8/8/8/8/1K6/k7 b - - 0 1", DRAW_NONE},
+  {"8/8/8/8/8/8/8/k1K5 w - - 0 1", DRAW_INSUFFICIENT_MATERIAL},
+  {"k7/8/8/8/8/8/8/7K b - - 0 1", DRAW_INSUFFICIENT_MATERIAL},
+  {"k7/8/8/8/8/8/8/6NK w - - 0 1", DRAW_NONE},
+  {"k7/8/8/8/8/8/8/6NK w - - 100 60", DRAW_FIFTY_MOVES},
+};
+
+typedef struct {
+  PieceType squares[BOARD_HEIGHT][BOARD_WIDTH];
+  int w_to_move;
+} RefBoard;
+
+// ----------------------------------------
+// REFERENCE GENERATOR
+
+static int ref_is_white(PieceType t) {
+  return t >= W_KING && t <= W_PAWN;
+}
+
+static int ref_own(const RefBoard *b, int x, int y) {
+  PieceType t = b->squares[y][x];
+  return t != EMPTY && ref_is_white(t) == b->w_to_move;
+}
+
+static int ref_enemy(const RefBoard *b, int x, int y) {
+  PieceType t = b->squares[y][x];
+  return t != EMPTY && ref_is_white(t) != b->w_to_move;
+}
+
+static int ref_inside(int x, int y) {
+  return x >= 0 && x < BOARD_WIDTH && y >= 0 && y < BOARD_HEIGHT;
+}
+
+static void ref_add(Move *moves, int *count, int x, int y, int nx, int ny) {
+  moves[(*count)++] = (Move) {{x, y}, {nx, ny}};
+}
+
+static void ref_steps(const RefBoard *b, Move *moves, int *count, int x, int y,
+		      const int (*steps)[2], int steps_count, int slide) {
+  for (int i = 0; i < steps_count; i++) {
+    int nx = x + steps[i][0], ny = y + steps[i][1];
+
+    while (ref_inside(nx, ny) && !ref_own(b, nx, ny)) {
+      ref_add(moves, count, x, y, nx, ny);
+      if (!slide || ref_enemy(b, nx, ny)) {
+	break;
+      }
+      nx += steps[i][0];
+      ny += steps[i][1];
+    }
+  }
+}
+
+static int ref_generate(const RefBoard *b, Move *moves) {
+  static const int KNIGHT[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+  static const int KING[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+  static const int ROOK[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  static const int BISHOP[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+  int count = 0;
+
+  for (int y = 0; y < BOARD_HEIGHT; y++) {
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+      if (!ref_own(b, x, y)) {
+	continue;
+      }
+
+      switch (b->squares[y][x]) {
+      case B_PAWN:
+      case W_PAWN: {
+	// black pawns go down the board, white pawns go up. The square
+	// jumped over by a double push is not checked.
+	int dy = b->w_to_move ? -1 : 1;
+	int start_y = b->w_to_move ? BOARD_HEIGHT - 2 : 1;
+
+	if (ref_inside(x, y + dy) && b->squares[y + dy][x] == EMPTY) {
+	  ref_add(moves, &count, x, y, x, y + dy);
+	}
+	if (y == start_y && b->squares[y + 2 * dy][x] == EMPTY) {
+	  ref_add(moves, &count, x, y, x, y + 2 * dy);
+	}
+	for (int dx = -1; dx <= 1; dx += 2) {
+	  if (ref_inside(x + dx, y + dy) && ref_enemy(b, x + dx, y + dy)) {
+	    ref_add(moves, &count, x, y, x + dx, y + dy);
+	  }
+	}
+	break;
+      }
+
+      case B_KNIGHT: case W_KNIGHT: ref_steps(b, moves, &count, x, y, KNIGHT, 8, 0); break;
+      case B_KING:   case W_KING:   ref_steps(b, moves, &count, x, y, KING, 8, 0); break;
+      case B_ROOK:   case W_ROOK:   ref_steps(b, moves, &count, x, y, ROOK, 4, 1); break;
+      case B_BISHOP: case W_BISHOP: ref_steps(b, moves, &count, x, y, BISHOP, 4, 1); break;
+      case B_QUEEN:  case W_QUEEN:
+	ref_steps(b, moves, &count, x, y, ROOK, 4, 1);
+	ref_steps(b, moves, &count, x, y, BISHOP, 4, 1);
+	break;
+
+      default:
+	break;
+      }
+    }
+  }
+
+  return count;
+}
+
+static long ref_perft(const RefBoard *b, int depth) {
+  if (depth == 0) {
+    return 1;
+  }
+
+  Move moves[MAX_MOVES * 4];
+  int count = ref_generate(b, moves);
+  if (depth == 1) {
+    return count;
+  }
+
+  long nodes = 0;
+  for (int i = 0; i < count; i++) {
+    RefBoard next = *b;
+    next.squares[moves[i].end.y][moves[i].end.x] = next.squares[moves[i].start.y][moves[i].start.x];
+    next.squares[moves[i].start.y][moves[i].start.x] = EMPTY;
+    next.w_to_move = !b->w_to_move;
+    nodes += ref_perft(&next, depth - 1);
+  }
+
+  return nodes;
+}
+
+// ----------------------------------------
+// GAME UNDER TEST
+
+static long game_perft(Game *game, int depth) {
+  if (depth == 0) {
+    return 1;
+  }
+
+  Move moves[MAX_MOVES];
+  int count = generate_moves(game, moves, MAX_MOVES);
+  if (depth == 1) {
+    return count;
+  }
+
+  long nodes = 0;
+  for (int i = 0; i < count; i++) {
+    Undo u;
+    make_move(game, moves[i], &u);
+    nodes += game_perft(game, depth - 1);
+    unmake_move(game, &u);
+  }
+
+  return nodes;
+}
+
+static void board_to_game(const RefBoard *b, Game *game) {
+  memset(game, 0, sizeof(*game));
+
+  for (int y = 0; y < BOARD_HEIGHT; y++) {
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+      PieceType t = b->squares[y][x];
+      game->board[x][y] = t != EMPTY ? init_piece(game, t, (Pos) {x, y}) : NULL;
+    }
+  }
+
+  game->b_player.player_name = B_PLAYER_NAME;
+  game->w_player.player_name = W_PLAYER_NAME;
+  game->selected_player = b->w_to_move ? &game->w_player : &game->b_player;
+  reset_history(game, 0);
+}
+
+static void board_to_fen(const RefBoard *b, char *fen) {
+  static Game game;
+  PosRecord r;
+
+  board_to_game(b, &game);
+  record_from_game(&r, &game);
+  record_to_fen(&r, fen, FEN_MAX_LEN);
+}
+
+// ----------------------------------------
+// COMPARISON
+
+static int compare_moves(const void *a, const void *b) {
+  const Move *m1 = a, *m2 = b;
+  int k1 = ((m1->start.y * BOARD_WIDTH + m1->start.x) << 6) | (m1->end.y * BOARD_WIDTH + m1->end.x);
+  int k2 = ((m2->start.y * BOARD_WIDTH + m2->start.x) << 6) | (m2->end.y * BOARD_WIDTH + m2->end.x);
+  return k1 - k2;
+}
+
+// Returns the smallest depth (up to `depth`) at which the two
+// generators disagree on `b`, or 0 if they always agree. When `log`
+// is set the disagreement is described on stderr.
+static int diverges(const RefBoard *b, int depth, int log) {
+  static Game game;
+  Move expected[MAX_MOVES * 4], found[MAX_MOVES];
+
+  board_to_game(b, &game);
+
+  int expected_count = ref_generate(b, expected);
+  int found_count = generate_moves(&game, found, MAX_MOVES);
+
+  qsort(expected, expected_count, sizeof(Move), compare_moves);
+  qsort(found, found_count, sizeof(Move), compare_moves);
+
+  int i = 0, j = 0, bad = 0;
+  while (i < expected_count || j < found_count) {
+    int cmp = i == expected_count ? 1 : j == found_count ? -1 : compare_moves(&expected[i], &found[j]);
+    char mv[5];
+
+    if (cmp == 0) {
+      i++, j++;
+      continue;
+    }
+
+    bad = 1;
+    format_move(cmp < 0 ? expected[i++] : found[j++], mv);
+    if (log) {
+      fprintf(stderr, "  %s %s\n", mv, cmp < 0 ? "is missing" : "should not be there");
+    }
+  }
+  if (bad) {
+    return 1;
+  }
+
+  for (int d = 2; d <= depth; d++) {
+    long ref = ref_perft(b, d);
+    long nodes = game_perft(&game, d);
+
+    if (ref != nodes) {
+      if (log) {
+	fprintf(stderr, "  perft(%d) is %ld instead of %ld\n", d, nodes, ref);
+      }
+      return d;
+    }
+  }
+
+  return 0;
+}
+
+// Removes pieces from `b` as long as the generators keep disagreeing.
+static void minimize(RefBoard *b, int depth) {
+  int changed = 1;
+
+  while (changed) {
+    changed = 0;
+
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+      for (int x = 0; x < BOARD_WIDTH; x++) {
+	PieceType t = b->squares[y][x];
+	if (t == EMPTY) {
+	  continue;
+	}
+
+	b->squares[y][x] = EMPTY;
+	if (diverges(b, depth, 0)) {
+	  changed = 1;
+	} else {
+	  b->squares[y][x] = t;
+	}
+      }
+    }
+  }
+}
+
+static int report(RefBoard *b, int depth, const char *repro_path) {
+  char fen[FEN_MAX_LEN];
+  board_to_fen(b, fen);
+  fprintf(stderr, "[ERROR] - Generators disagree on %s\n", fen);
+
+  int d = diverges(b, depth, 0);
+  minimize(b, d);
+  board_to_fen(b, fen);
+
+  fprintf(stderr, "Minimized to %s\n", fen);
+  diverges(b, d, 1);
+
+  FILE *f = fopen(repro_path, "w");
+  if (!f) {
+    fprintf(stderr, "[ERROR] - Could not open %s\n", repro_path);
+    return 1;
+  }
+  fprintf(f, "# replay with: ./difftest -f %s -d %d\n%s\n", repro_path, d, fen);
+  fclose(f);
+
+  fprintf(stderr, "Reproducer written to %s\n", repro_path);
+  return 1;
+}
+
+// Returns 1 if check_draw() gives the expected result on every one of
+// DRAW_CASES.
+static int check_draw_cases(void) {
+  static Game game;
+  int ok = 1;
+
+  for (size_t i = 0; i < sizeof(DRAW_CASES) / sizeof(DRAW_CASES[0]); i++) {
+    PosRecord r;
+    if (!fen_to_record(DRAW_CASES[i].fen, &r)) {
+      fprintf(stderr, "[ERROR] - Invalid FEN %s\n", DRAW_CASES[i].fen);
+      return 0;
+    }
+
+    record_to_game(&r, &game);
+    DrawReason found = check_draw(&game);
+    if (found != DRAW_CASES[i].expected) {
+      fprintf(stderr, "[ERROR] - check_draw() of %s is %s instead of %s\n", DRAW_CASES[i].fen,
+	      draw_reason_name(found), draw_reason_name(DRAW_CASES[i].expected));
+      ok = 0;
+    }
+  }
+
+  return ok;
+}
+
+// ----------------------------------------
+
+static void load_default_board(RefBoard *b) {
+  memcpy(b->squares, DEFAULT_BOARD, sizeof(b->squares));
+  b->w_to_move = 0;
+}
+
+static int load_repro(const char *path, RefBoard *b) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "[ERROR] - Could not open %s\n", path);
+    return 0;
+  }
+
+  char line[FEN_MAX_LEN * 2];
+  PosRecord r;
+  int ok = 0;
+
+  while (!ok && fgets(line, sizeof(line), f)) {
+    ok = line[0] != '#' && fen_to_record(line, &r);
+  }
+  fclose(f);
+
+  if (!ok) {
+    fprintf(stderr, "[ERROR] - No FEN found in %s\n", path);
+    return 0;
+  }
+
+  for (int sq = 0; sq < BOARD_WIDTH * BOARD_HEIGHT; sq++) {
+    b->squares[sq / BOARD_WIDTH][sq % BOARD_WIDTH] = record_piece_at(&r, sq);
+  }
+  b->w_to_move = r.w_to_move;
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  int playouts = DEFAULT_PLAYOUTS, max_plies = DEFAULT_MAX_PLIES, depth = DEFAULT_DEPTH;
+  unsigned seed = 0;
+  const char *repro_path = DEFAULT_REPRO_PATH, *replay_path = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:m:d:s:o:f:")) != -1) {
+    switch (opt) {
+    case 'n': playouts = atoi(optarg); break;
+    case 'm': max_plies = atoi(optarg); break;
+    case 'd': depth = atoi(optarg); break;
+    case 's': seed = (unsigned) strtoul(optarg, NULL, 10); break;
+    case 'o': repro_path = optarg; break;
+    case 'f': replay_path = optarg; break;
+    default:
+      fprintf(stderr, "Usage: %s [-n playouts] [-m max_plies] [-d depth] [-s seed] [-o repro.fen]\n"
+	      "       %s -f repro.fen [-d depth]\n", argv[0], argv[0]);
+      return 1;
+    }
+  }
+
+  if (depth < 1) {
+    fprintf(stderr, "[ERROR] - depth must be positive\n");
+    return 1;
+  }
+
+  RefBoard b;
+
+  if (replay_path) {
+    if (!load_repro(replay_path, &b)) {
+      return 1;
+    }
+    int d = diverges(&b, depth, 1);
+    printf("%s\n", d ? "Generators disagree" : "Generators agree");
+    return d != 0;
+  }
+
+  // known counts first
+  load_default_board(&b);
+  static Game game;
+  board_to_game(&b, &game);
+
+  for (int d = 1; d <= START_PERFT_DEPTH; d++) {
+    long nodes = game_perft(&game, d);
+    if (nodes != ref_perft(&b, d)) {
+      return report(&b, d, repro_path);
+    }
+    if (nodes != START_PERFT[d]) {
+      fprintf(stderr, "[ERROR] - perft(%d) of the starting position is %ld instead of %ld\n",
+	      d, nodes, START_PERFT[d]);
+      return 1;
+    }
+  }
+
+  if (!check_draw_cases()) {
+    return 1;
+  }
+
+  srand(seed);
+  long positions = 0;
+
+  for (int n = 0; n < playouts; n++) {
+    load_default_board(&b);
+
+    for (int ply = 0; ply < max_plies; ply++) {
+      positions++;
+      if (diverges(&b, depth, 0)) {
+	fprintf(stderr, "Playout %d (seed %u), ply %d\n", n, seed, ply);
+	return report(&b, depth, repro_path);
+      }
+
+      Move moves[MAX_MOVES * 4];
+      int count = ref_generate(&b, moves);
+      if (count == 0) {
+	break;
+      }
+
+      Move m = moves[rand() % count];
+      PieceType eaten = b.squares[m.end.y][m.end.x];
+      b.squares[m.end.y][m.end.x] = b.squares[m.start.y][m.start.x];
+      b.squares[m.start.y][m.start.x] = EMPTY;
+      b.w_to_move = !b.w_to_move;
+
+      if (eaten == B_KING || eaten == W_KING) {
+	break;
+      }
+    }
+  }
+
+  printf("%d playouts, %ld positions: generators agree up to depth %d\n", playouts, positions, depth);
+  return 0;
+}
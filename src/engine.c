@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "./include/game.h"
+#include "./include/book.h"
+#include "./include/tb.h"
+#include "./include/engine.h"
+
+// ----------------------------------------
+// GLOBAL VARIABLES
+
+const int PIECE_VALUE[] = {
+  [B_KING] = 0, [B_QUEEN] = 900, [B_ROOK] = 500, [B_BISHOP] = 330, [B_KNIGHT] = 320, [B_PAWN] = 100,
+  [W_KING] = 0, [W_QUEEN] = 900, [W_ROOK] = 500, [W_BISHOP] = 330, [W_KNIGHT] = 320, [W_PAWN] = 100,
+};
+
+// ----------------------------------------
+// FUNCTIONS
+
+// Material balance from the point of view of the selected player.
+int evaluate(const Game *game) {
+  int score = 0;
+
+  for (int x = 0; x < BOARD_WIDTH; x++) {
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+      const Piece *p = game->board[x][y];
+      if (p) {
+	score += IS_PIECE_WHITE(p->type) ? PIECE_VALUE[p->type] : -PIECE_VALUE[p->type];
+      }
+    }
+  }
+
+  return IS_PLAYER_WHITE(game) ? score : -score;
+}
+
+// Negamax alpha-beta search. Since the game ends as soon as a king is
+// eaten, a move that captures the king is worth MATE_SCORE (minus the
+// distance from the root, so that faster wins are preferred).
+//
+// A position already reached, in the game or along the searched line,
+// is scored as a draw, as is one drawn by the 50-move rule.
+int search(Engine *e, Game *game, int depth, int ply, int alpha, int beta) {
+  e->nodes++;
+
+  if (count_repetitions(game) > 0 || game->halfmove_clock >= FIFTY_MOVES_PLIES) {
+    return 0;
+  }
+
+  TbWdl wdl = tb_probe_wdl(game);
+  if (wdl != TB_FAILED) {
+    return wdl == TB_WIN ? TABLEBASE_WIN_SCORE - ply : wdl == TB_LOSS ? -TABLEBASE_WIN_SCORE + ply : 0;
+  }
+
+  if (depth == 0) {
+    return evaluate(game);
+  }
+
+  Move moves[MAX_MOVES];
+  int count = generate_moves(game, moves, MAX_MOVES);
+
+  for (int i = 0; i < count; i++) {
+    Piece *eating_piece = game->board[moves[i].end.x][moves[i].end.y];
+    if (eating_piece && (eating_piece->type == B_KING || eating_piece->type == W_KING)) {
+      return MATE_SCORE - ply;
+    }
+  }
+
+  if (count == 0) {
+    return 0;
+  }
+
+  for (int i = 0; i < count; i++) {
+    Undo u;
+    make_move(game, moves[i], &u);
+    int score = -search(e, game, depth - 1, ply + 1, -beta, -alpha);
+    unmake_move(game, &u);
+
+    if (score >= beta) {
+      return beta;
+    }
+    if (score > alpha) {
+      alpha = score;
+    }
+  }
+
+  return alpha;
+}
+
+// Chooses the move of the selected player, taking it from the
+// opening book or from the endgame tables when the position is in
+// there. Endgame tables are used whenever tb_init() has been called.
+//
+// Returns 0 if the player has no move at all.
+int engine_pick_move(Engine *e, Game *game, Move *out) {
+  e->nodes = 0;
+
+  if (e->book && book_probe(e->book, game, e->book_select, out)) {
+    return 1;
+  }
+
+  TbWdl wdl;
+  int distance;
+  if (tb_probe_root(game, out, &wdl, &distance)) {
+    return 1;
+  }
+
+  Move moves[MAX_MOVES];
+  int count = generate_moves(game, moves, MAX_MOVES);
+  if (count == 0) {
+    return 0;
+  }
+
+  int alpha = -MATE_SCORE - 1;
+  *out = moves[0];
+
+  for (int i = 0; i < count; i++) {
+    Piece *eating_piece = game->board[moves[i].end.x][moves[i].end.y];
+    if (eating_piece && (eating_piece->type == B_KING || eating_piece->type == W_KING)) {
+      *out = moves[i];
+      return 1;
+    }
+
+    Undo u;
+    make_move(game, moves[i], &u);
+    int score = -search(e, game, e->depth - 1, 1, -MATE_SCORE - 1, -alpha);
+    unmake_move(game, &u);
+
+    if (score > alpha) {
+      alpha = score;
+      *out = moves[i];
+    }
+  }
+
+  return 1;
+}
@@ -0,0 +1,53 @@
+/*
+  Fuzz target for FEN parsing.
+
+  Every input is parsed with fen_to_record(). Whatever is accepted
+  must survive a round trip through record_to_fen(), and through a
+  Game with record_to_game() and record_from_game().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+#include "./include/fuzz.h"
+
+static int same_position(const PosRecord *a, const PosRecord *b) {
+  return a->occupancy == b->occupancy && a->w_to_move == b->w_to_move &&
+    !memcmp(a->pieces, b->pieces, sizeof(a->pieces));
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  char fen[FUZZ_MAX_INPUT + 1];
+  if (size > FUZZ_MAX_INPUT) {
+    size = FUZZ_MAX_INPUT;
+  }
+  memcpy(fen, data, size);
+  fen[size] = '\0';
+
+  PosRecord r;
+  if (!fen_to_record(fen, &r)) {
+    return 0;
+  }
+
+  // the FEN written back must give the very same record
+  char out[FEN_MAX_LEN];
+  PosRecord again;
+  record_to_fen(&r, out, sizeof(out));
+  FUZZ_CHECK(strlen(out) < FEN_MAX_LEN - 1);
+  FUZZ_CHECK(fen_to_record(out, &again));
+  FUZZ_CHECK(same_position(&r, &again));
+  FUZZ_CHECK(r.halfmove_clock == again.halfmove_clock && r.fullmove_number == again.fullmove_number);
+
+  // and so must a game set up from it
+  static Game game;
+  record_to_game(&r, &game);
+  FUZZ_CHECK(game.key == compute_position_key(&game));
+
+  record_from_game(&again, &game);
+  FUZZ_CHECK(same_position(&r, &again));
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+/*
+  Standalone driver for the fuzz targets, used when libFuzzer is not
+  available.
+
+    ./fuzz_fen [input ...]
+
+  Every input file is run once through the target, which is how
+  crashes found by a fuzzer are replayed. Without files a single input
+  is read from stdin, which is what AFL expects:
+
+    afl-fuzz -i seeds -o findings -- ./fuzz_fen
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "./include/fuzz.h"
+
+static size_t read_input(FILE *f, uint8_t *data) {
+  return fread(data, 1, FUZZ_MAX_INPUT, f);
+}
+
+int main(int argc, char **argv) {
+  static uint8_t data[FUZZ_MAX_INPUT];
+
+  if (argc == 1) {
+    size_t size = read_input(stdin, data);
+    LLVMFuzzerTestOneInput(data, size);
+    return 0;
+  }
+
+  for (int i = 1; i < argc; i++) {
+    FILE *f = fopen(argv[i], "rb");
+    if (!f) {
+      fprintf(stderr, "[ERROR] - Could not open %s\n", argv[i]);
+      return 1;
+    }
+
+    size_t size = read_input(f, data);
+    fclose(f);
+
+    LLVMFuzzerTestOneInput(data, size);
+  }
+
+  printf("%d inputs ok\n", argc - 1);
+  return 0;
+}
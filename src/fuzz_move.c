@@ -0,0 +1,148 @@
+/*
+  Fuzz target for move application.
+
+  An input is an optional FEN terminated by '\n', followed by moves
+  two bytes each: one for the starting square and one for the ending
+  one, with x in the low nibble and y in the high nibble (both offset
+  by 4, so that squares out of the board are tried too). Without a
+  FEN the game starts from DEFAULT_BOARD.
+
+  Moves go through the same checks done by the server, and for every
+  position the rules are cross-checked against each other:
+  validate_move(), generate_moves(), update_valid_moves(),
+  make_move()/unmake_move() and the incremental Zobrist key. Positions
+  drawn for lack of material must not allow eating a king.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+#include "./include/fuzz.h"
+
+static Pos decode_square(uint8_t b) {
+  return (Pos) {.x = (b & 0xF) - 4, .y = (b >> 4) - 4};
+}
+
+static int same_move(Move a, Move b) {
+  return a.start.x == b.start.x && a.start.y == b.start.y &&
+    a.end.x == b.end.x && a.end.y == b.end.y;
+}
+
+static void check_position(Game *game, const Move *moves, int count) {
+  PosRecord before, after;
+  record_from_game(&before, game);
+  uint64_t key = game->key;
+  int ply = game->ply;
+
+  for (int i = 0; i < count; i++) {
+    Undo u;
+    make_move(game, moves[i], &u);
+    FUZZ_CHECK(game->key == compute_position_key(game));
+    unmake_move(game, &u);
+
+    record_from_game(&after, game);
+    FUZZ_CHECK(!memcmp(&before, &after, sizeof(before)));
+    FUZZ_CHECK(game->key == key && game->ply == ply);
+  }
+}
+
+// The squares highlighted when the piece on `start` is selected must
+// be the ends of the moves starting there.
+static void check_valid_moves(Game *game, Pos start, const Move *moves, int count) {
+  update_selected_piece(game, start);
+  if (!game->selected_piece) {
+    return;
+  }
+
+  int expected = 0;
+  for (int i = 0; i < count; i++) {
+    if (moves[i].start.x != start.x || moves[i].start.y != start.y) {
+      continue;
+    }
+    expected++;
+
+    int found = 0;
+    for (int j = 0; j < game->valid_moves_count; j++) {
+      found |= same_move(moves[i], (Move) {start, game->valid_moves[j]});
+    }
+    FUZZ_CHECK(found);
+  }
+  FUZZ_CHECK(expected == game->valid_moves_count);
+
+  game->selected_piece = NULL;
+  game->valid_moves_count = 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static Game game;
+  size_t i = 0;
+
+  if (size > FUZZ_MAX_INPUT) {
+    size = FUZZ_MAX_INPUT;
+  }
+
+  const uint8_t *newline = memchr(data, '\n', size);
+  if (newline) {
+    char fen[FUZZ_MAX_INPUT + 1];
+    PosRecord r;
+
+    memcpy(fen, data, newline - data);
+    fen[newline - data] = '\0';
+    if (!fen_to_record(fen, &r)) {
+      return 0;
+    }
+
+    record_to_game(&r, &game);
+    i = newline - data + 1;
+  } else {
+    memset(&game, 0, sizeof(game));
+    init_game(&game);
+  }
+
+  Move moves[MAX_MOVES];
+
+  for (; i + 1 < size; i += 2) {
+    Move m = {decode_square(data[i]), decode_square(data[i + 1])};
+    int count = generate_moves(&game, moves, MAX_MOVES);
+    if (count == MAX_MOVES) {
+      // the list may have been cut, it can not be compared
+      break;
+    }
+
+    int expected = 0;
+    for (int j = 0; j < count; j++) {
+      expected |= same_move(m, moves[j]);
+    }
+    FUZZ_CHECK(validate_move(&game, m) == expected);
+
+    check_position(&game, moves, count);
+    if (!out_of_board_pos(m.start)) {
+      check_valid_moves(&game, m.start, moves, count);
+    }
+
+    if (!expected) {
+      continue;
+    }
+
+    int finished = move_piece(&game, game.board[m.start.x][m.start.y], m.end);
+    FUZZ_CHECK(game.key == compute_position_key(&game));
+
+    DrawReason draw = check_draw(&game);
+    if (draw == DRAW_INSUFFICIENT_MATERIAL) {
+      // a dead draw can not allow eating a king
+      count = generate_moves(&game, moves, MAX_MOVES);
+      for (int j = 0; j < count; j++) {
+	FUZZ_CHECK(game.board[moves[j].end.x][moves[j].end.y] == NULL);
+      }
+    }
+
+    if (finished || draw != DRAW_NONE) {
+      break;
+    }
+  }
+
+  return 0;
+}
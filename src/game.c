@@ -1,8 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "./include/game.h"
+#include "./include/tables.h"
 
 // ----------------------------------------
 // GLOBAL VARIABLES
@@ -48,45 +50,53 @@ const char *type2png(PieceType t) {
 
 void init_game(Game *game) {
   game->quit = 0;
+  game->pieces_count = 0;
 
   // init board logical state
   for (int x = 0; x < BOARD_WIDTH; x++) {
     for (int y = 0; y < BOARD_HEIGHT; y++) {
       // NOTE: swap coords to follow SDL2 coord scheme
       PieceType t = DEFAULT_BOARD[y][x];
-      game->board[x][y] = t != EMPTY ? init_piece(t, (Pos){x, y}) : NULL;
+      game->board[x][y] = t != EMPTY ? init_piece(game, t, (Pos){x, y}) : NULL;
     }
   }
 
   game->valid_moves_count = 0;
+  game->selected_piece = NULL;
   
   game->b_player.player_name = B_PLAYER_NAME;
   game->w_player.player_name = W_PLAYER_NAME;
+  game->b_player.score_count = 0;
+  game->w_player.score_count = 0;
   
   // NOTE: we assume black starts
   game->selected_player= &game->b_player;
+
+  game->start_ply = 0;
+  reset_history(game, 0);
 }
 
+// Pieces live inside the game itself, so there is nothing to free:
+// the board is simply emptied.
 void destroy_game(Game *game) {
-  for (int x = 0; x < BOARD_WIDTH; x++) {
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-      if (game->board[x][y]) {
-	destroy_piece(game->board[x][y]);
-      }
-    }
-  }
+  memset(game->board, 0, sizeof(game->board));
+  game->pieces_count = 0;
+  game->selected_piece = NULL;
 }
 
 // ----------
 
 // Used to istantiate a particular chess piece depending on its type.
+// The piece is taken from the pool of the game, no memory is
+// allocated.
 //
-// NOTE: The texture instantiation is de-ferred to the first call of
+// NOTE: Textures are shared by all pieces of the same type, see
 // render_piece().
-Piece *init_piece(PieceType t, Pos init_pos) {
+Piece *init_piece(Game *game, PieceType t, Pos init_pos) {
   assert(t != EMPTY && "Piece shouldn't be EMPTY!");
+  assert(game->pieces_count < MAX_PIECES && "too many pieces!");
   
-  Piece *p = calloc(1, sizeof(Piece));
+  Piece *p = &game->pieces[game->pieces_count++];
   p->pos = init_pos;
   p->type = t;
   p->image_path = type2png(t);
@@ -94,12 +104,6 @@ Piece *init_piece(PieceType t, Pos init_pos) {
   return p;
 }
 
-void destroy_piece(Piece *p) {
-  SDL_DestroyTexture(p->texture);
-  SDL_FreeSurface(p->image);
-  free(p);
-}
-
 void update_selected_piece(Game *game, Pos p) {
   // we only update the selected piece if the player is trying to pick
   // his/her own pieces, and not the enemies's.
@@ -121,29 +125,6 @@ void update_selected_piece(Game *game, Pos p) {
 
 // ----------
 
-// Computes direction of movement based on starting pos and ending pos.
-Dir compute_movement_dir(Pos start_pos, Pos end_pos) {
-  int dx = end_pos.x - start_pos.x;
-  int dy = end_pos.y - start_pos.y;
-
-  if (dx == 0 && dy == 0) { return STILL; }
-  
-  // basic 4-movements
-  if (dx == 0 && dy < 0)  { return UP;      }
-  if (dx == 0 && dy > 0)  { return DOWN;    }
-  if (dy == 0 && dx < 0)  { return LEFT;    }  
-  if (dy == 0 && dx > 0)  { return RIGHT;   }
-
-  // other 4-diagonal movements
-  if (dy < 0  && dx < 0)  { return DIAG_LU; }
-  if (dy < 0  && dx > 0)  { return DIAG_RU; }
-  if (dy > 0  && dx < 0)  { return DIAG_LD; }
-  if (dy > 0  && dx > 0)  { return DIAG_RD; }
-
-  fprintf(stderr, "[ERROR] - dx (%d) and dy (%d) are not valid!\n", dx, dy);
-  exit(1);
-}
-
 int out_of_board_pos(Pos pos) {
   // Returns 1 if `pos` is out of the board.
 
@@ -161,99 +142,55 @@ int out_of_board_pos(Pos pos) {
 int check_move_validity(Game *game, Piece *p, Pos new_pos) {
   // returns 1 if the piece p can move from its current position to
   // new_pos, 0 otherwise.
-  Pos old_pos = p->pos;
-  Piece *eating_piece = game->board[new_pos.x][new_pos.y];
-  Dir movement_dir = compute_movement_dir(p->pos, new_pos);
-
-  if (movement_dir == STILL || out_of_board_pos(new_pos)) {
+  if (out_of_board_pos(new_pos)) {
     return 0; // edge-case cases
   }
-  
-  int dx = new_pos.x - old_pos.x;
-  int dy = new_pos.y - old_pos.y;
+
+  int from = SQUARE(p->pos);
+  uint64_t to = SQUARE_BIT(SQUARE(new_pos));
+  Piece *eating_piece = game->board[new_pos.x][new_pos.y];
 
   switch(p->type) {
 
-    // at the start the pawn can choose to move two squares below.
-    // in general however it can only move one square below.     
+    // at the start the pawn can choose to move two squares ahead, in
+    // general however it can only move one square ahead.
   case B_PAWN:
-    if (!eating_piece &&
-	((old_pos.y == 1 && dy == 2 && dx == 0) || (dy == 1 && dx == 0))) {
-      return 1;
-    }
-
-    else if (eating_piece && dy == 1 && abs(dx) == 1) {
-      return 1;
-    }
-    
-    break;
-
-  case W_PAWN:
-    if (!eating_piece &&
-	((old_pos.y == 6 && dy == -2 && dx == 0) || (dy == -1 && dx == 0))) {
-      return 1;
-    }
+  case W_PAWN: {
+    int side = p->type == B_PAWN ? TABLE_BLACK : TABLE_WHITE;
 
-    else if (eating_piece && dy == -1 && abs(dx) == 1) {
-      return 1;
-    }    
-    
-    break;
+    // NOTE: the square jumped over by a double push is not checked.
+    return ((eating_piece ? PAWN_ATTACKS[side][from] : PAWN_PUSHES[side][from]) & to) != 0;
+  }
 
   // -----------
   case B_ROOK:
   case W_ROOK:
-
-    if ((dy && !dx) || (!dy && dx)) {
-      return check_obstacles_in_path(game, p->pos, new_pos, movement_dir);
-    }
-    
-    break;
+    return (ROOK_ATTACKS[from] & to) && check_obstacles_in_path(game, p->pos, new_pos);
 
   // -----------
   case B_BISHOP:
   case W_BISHOP:
-
-    if (abs(dx) == abs(dy)) {
-      return check_obstacles_in_path(game, p->pos, new_pos, movement_dir);
-    }
-    
-    break;
+    return (BISHOP_ATTACKS[from] & to) && check_obstacles_in_path(game, p->pos, new_pos);
     
   // -----------
   case B_KNIGHT:
   case W_KNIGHT:
     // NOTE: here we don't have to check for obstacles.
-    if ((dy == -2 && (dx == -1 || dx == 1)) || (dy == 2 && (dx == -1 || dx == 1))  ||
-	(dx == -2 && (dy == -1 || dy == 1)) || (dx == 2 && (dy == -1 || dy == 1))) {
-      return 1;
-    }
-    
-    break;
+    return (KNIGHT_ATTACKS[from] & to) != 0;
 
   // -----------
   case B_QUEEN:
   case W_QUEEN:
-    
-    if ((abs(dx) == abs(dy)) || (dy && !dx) || (!dy && dx)) {
-      return check_obstacles_in_path(game, p->pos, new_pos, movement_dir);
-    }
-
-    break;
+    return ((ROOK_ATTACKS[from] | BISHOP_ATTACKS[from]) & to) &&
+      check_obstacles_in_path(game, p->pos, new_pos);
 
   // -----------
   case B_KING:
   case W_KING:
-
-    if ((dy == 0 || dy == 1 || dy == -1) && (dx == 0 || dx == 1 || dx == -1)) {
-      return 1;
-    }
-    
-    break;
+    return (KING_ATTACKS[from] & to) != 0;
 
   default:
-    fprintf(stderr, "[ERROR] - Default clause in check move (%d)!\n", p->type);
-    exit(1);
+    // not a piece, nothing to move.
     break;
   }
 
@@ -263,107 +200,70 @@ int check_move_validity(Game *game, Piece *p, Pos new_pos) {
 // This function should return 1 if the path is 'free of obstacles',
 // and 0 otherwise.
 //
-// To specify a path we need to specify a starting position, an ending
-// position, and a direction of movement.  Possible directions are:
-int check_obstacles_in_path(Game *game, Pos start_pos, Pos end_pos, Dir dir) {
-  switch(dir) {
-
-  case UP:
-    // we're moving UP, from higher y-coords to lower y-coords
-    for (int y = start_pos.y - 1; y > end_pos.y; y--) {
-      if(game->board[start_pos.x][y]) {
-	return 0;
-      }
+// The path goes from `start_pos` to `end_pos`, both excluded, which
+// must be on the same row, column or diagonal.
+int check_obstacles_in_path(Game *game, Pos start_pos, Pos end_pos) {
+  uint64_t path = BETWEEN[SQUARE(start_pos)][SQUARE(end_pos)];
+
+  while (path) {
+    int sq = __builtin_ctzll(path);
+    if (game->board[sq % BOARD_WIDTH][sq / BOARD_WIDTH]) {
+      return 0;
     }
-    
-    break;
+    path &= path - 1;
+  }
 
-  case DOWN:
-    // we're moving DOWN, from lower y-coords to higher y-coords
-    for (int y = start_pos.y + 1; y < end_pos.y; y++) {
-      if(game->board[start_pos.x][y]) {
-	return 0;
-      }
-    }
-    break;
-    
-  case LEFT:
-    // we're moving LEFT, from higher x-coords to lower x-coords
-    for (int x = start_pos.x - 1; x > end_pos.x; x--) {
-      if(game->board[x][start_pos.y]) {
-	return 0;
-      }
-    }    
-    
-    break;
-    
-  case RIGHT:
-    // we're moving RIGHT, from lower x-coords to higher x-coords
-    for (int x = start_pos.x + 1; x < end_pos.x; x++) {
-      if(game->board[x][start_pos.y]) {
-	return 0;
-      }
-    }
-    
-    break;
-  
-  case DIAG_LU:
-    // we're moving on the LEFT-UP DIAGONAL,
-    //   from higher x-coords to lower x-coords
-    //   from higher y-coords to lower y-coords
-    for (int x = start_pos.x - 1, y = start_pos.y - 1; x > end_pos.x && y > end_pos.y; x--, y--) {
-      if(game->board[x][y]) {
-	return 0;
-      }
-    }
-    
-    break;
-    
-  case DIAG_LD:
-    // we're moving on the LEFT-DOWN DIAGONAL,
-    //   from higher x-coords to lower x-coords
-    //   from lower y-coords to higher y-coords
-    for (int x = start_pos.x - 1, y = start_pos.y + 1; x > end_pos.x && y < end_pos.y; x--, y++) {
-      if(game->board[x][y]) {
-	return 0;
-      }
-    }
-    break;
-    
-  case DIAG_RU:
-    // we're moving on the RIGHT-UP DIAGONAL,
-    //   from lower x-coords to higher x-coords
-    //   from higher y-coords to lower y-coords
-    for (int x = start_pos.x + 1, y = start_pos.y - 1; x < end_pos.x && y > end_pos.y; x++, y--) {
-      if(game->board[x][y]) {
-	return 0;
-      }
-    }    
-    break;
-    
-  case DIAG_RD:
-    // we're moving on the RIGHT-DOWN DIAGONAL,
-    //   from lower x-coords to higher x-coords
-    //   from lower y-coords to higher y-coords
-    for (int x = start_pos.x + 1, y = start_pos.y + 1; x < end_pos.x && y < end_pos.y; x++, y++) {
-      if(game->board[x][y]) {
-	return 0;
-      }
-    }
-    break;
+  return 1;
+}
 
-  default:
-    fprintf(stderr, "[ERROR] - default case shoulnd't be triggered!\n");
-    exit(1);
-    break;
+// Returns the squares `p` could move to on an empty board, a superset
+// of where it can actually move.
+static uint64_t candidate_squares(const Piece *p) {
+  int sq = SQUARE(p->pos);
+
+  switch(p->type) {
+  case B_PAWN:   return PAWN_PUSHES[TABLE_BLACK][sq] | PAWN_ATTACKS[TABLE_BLACK][sq];
+  case W_PAWN:   return PAWN_PUSHES[TABLE_WHITE][sq] | PAWN_ATTACKS[TABLE_WHITE][sq];
+  case B_ROOK:
+  case W_ROOK:   return ROOK_ATTACKS[sq];
+  case B_BISHOP:
+  case W_BISHOP: return BISHOP_ATTACKS[sq];
+  case B_KNIGHT:
+  case W_KNIGHT: return KNIGHT_ATTACKS[sq];
+  case B_QUEEN:
+  case W_QUEEN:  return ROOK_ATTACKS[sq] | BISHOP_ATTACKS[sq];
+  case B_KING:
+  case W_KING:   return KING_ATTACKS[sq];
+  default:       return 0;
   }
+}
 
-  return 1;
+// Updates key and history of `game` once the piece of type `t` has
+// moved from `start` to `end`, eating `eaten_piece` (if any).
+static void push_position(Game *game, PieceType t, Pos start, Pos end, const Piece *eaten_piece, int player_changed) {
+  game->key ^= ZOBRIST_PIECES[t][SQUARE(start)] ^ ZOBRIST_PIECES[t][SQUARE(end)];
+  if (eaten_piece) {
+    game->key ^= ZOBRIST_PIECES[eaten_piece->type][SQUARE(end)];
+  }
+  if (player_changed) {
+    game->key ^= ZOBRIST_W_TO_MOVE;
+  }
+
+  // captures and pawn moves can not be taken back
+  if (eaten_piece || t == B_PAWN || t == W_PAWN) {
+    game->halfmove_clock = 0;
+  } else {
+    game->halfmove_clock++;
+  }
+
+  game->ply++;
+  game->history[game->ply & (GAME_HISTORY_SIZE - 1)] = game->key;
 }
 
 int move_piece(Game *game, Piece *p, Pos new_pos) {
   int finished = 0;
   Piece *eaten_piece = game->board[new_pos.x][new_pos.y];
+  Pos old_pos = p->pos;
   
   if(!check_move_validity(game, p, new_pos)) {
     return finished;
@@ -375,8 +275,6 @@ int move_piece(Game *game, Piece *p, Pos new_pos) {
 
     // check if game is over.
     finished = eaten_piece->type == B_KING || eaten_piece->type == W_KING;
-    
-    destroy_piece(eaten_piece);
   }
   
   game->board[p->pos.x][p->pos.y] = NULL;
@@ -390,6 +288,8 @@ int move_piece(Game *game, Piece *p, Pos new_pos) {
     game->selected_player = IS_PLAYER_WHITE(game) ? &game->b_player : &game->w_player;
   }
 
+  push_position(game, p->type, old_pos, new_pos, eaten_piece, !finished);
+
   // reset valid positions
   game->valid_moves_count = 0;
 
@@ -399,21 +299,21 @@ int move_piece(Game *game, Piece *p, Pos new_pos) {
 // ----------
 
 void update_player_score(Player *p, PieceType t) {
-  assert(p->score_count < 16 && "score count must be < 16!\n");
+  assert(p->score_count < MAX_PIECES && "score count must be < MAX_PIECES!\n");
   p->score[p->score_count++] = t;
 }
 
 // ----------
 
-void add_valid_move(Game *game, Pos new_pos) {
-  if (game->valid_moves_count + 1 >= MAX_VALID_MOVES) {
-    fprintf(stderr, "[ERROR] - Array valid_moves completely filled!");
-    exit(1);
+// Returns 0 if the array valid_moves is already full, 1 otherwise.
+int add_valid_move(Game *game, Pos new_pos) {
+  if (game->valid_moves_count >= MAX_VALID_MOVES) {
+    return 0;
   }
 
   game->valid_moves[game->valid_moves_count++] = new_pos;
 
-  return;
+  return 1;
 }
 
 // Determines which moves are valid out of all possible moves
@@ -426,22 +326,253 @@ void update_valid_moves(Game *game) {
     return; 
   }
 
-  // iterate over all possible position and check if piece can be
-  // moved there.
+  // iterate over the squares the piece could reach and check if it
+  // can be moved there.
+  uint64_t candidates = candidate_squares(game->selected_piece);
+
+  while (candidates) {
+    int sq = __builtin_ctzll(candidates);
+    candidates &= candidates - 1;
+
+    Pos p = (Pos) {.x = sq % BOARD_WIDTH, .y = sq / BOARD_WIDTH};
+    Piece *eating_piece = game->board[p.x][p.y];
+
+    // TODO: instead of checking here if we're trying to move on the
+    // player's own pieces, we should instead do that within the
+    // check_move_validity().
+    if (check_move_validity(game, game->selected_piece, p) &&
+	(!eating_piece || (eating_piece && !SAME_PLAYER(eating_piece, game->selected_piece))) &&
+	!add_valid_move(game, p)) {
+      break;
+    }
+  }
+
+  return;
+}
+
+// ----------
+
+// Tells whether the selected player can play `m`. Unlike
+// check_move_validity() any move is accepted, including ones starting
+// from an empty square or going out of the board.
+int validate_move(Game *game, Move m) {
+  if (out_of_board_pos(m.start) || out_of_board_pos(m.end)) {
+    return 0;
+  }
+
+  Piece *p = game->board[m.start.x][m.start.y];
+  Piece *eating_piece = game->board[m.end.x][m.end.y];
+
+  return p && OWNED_BY_PLAYER(game, p) &&
+    !(eating_piece && SAME_PLAYER(eating_piece, p)) &&
+    check_move_validity(game, p, m.end);
+}
+
+// ----------
+
+// Parses a move in coordinate notation (e.g. "e7e5"), where files go
+// from 'a' (x = 0) to 'h' and ranks from '8' (y = 0) to '1'.
+//
+// Returns 1 on success, 0 otherwise.
+int parse_move(const char *s, Move *m) {
+  for (int i = 0; i < 4; i++) {
+    if (!s[i]) {
+      return 0;
+    }
+  }
+
+  m->start = (Pos) {s[0] - 'a', BOARD_HEIGHT - (s[1] - '0')};
+  m->end = (Pos) {s[2] - 'a', BOARD_HEIGHT - (s[3] - '0')};
+
+  return !out_of_board_pos(m->start) && !out_of_board_pos(m->end);
+}
+
+// Writes `m` in coordinate notation, `s` must hold 5 chars.
+void format_move(Move m, char *s) {
+  s[0] = (char) ('a' + m.start.x);
+  s[1] = (char) ('0' + BOARD_HEIGHT - m.start.y);
+  s[2] = (char) ('a' + m.end.x);
+  s[3] = (char) ('0' + BOARD_HEIGHT - m.end.y);
+  s[4] = '\0';
+}
+
+// ----------
+
+// Computes the Zobrist key of the position from scratch.
+uint64_t compute_position_key(const Game *game) {
+  uint64_t key = IS_PLAYER_WHITE(game) ? ZOBRIST_W_TO_MOVE : 0;
+
   for (int x = 0; x < BOARD_WIDTH; x++) {
     for (int y = 0; y < BOARD_HEIGHT; y++) {
-      Pos p = (Pos) {.x = x, .y = y};
-      Piece *eating_piece = game->board[p.x][p.y];
-
-      // TODO: instead of checking here if we're trying to move on the
-      // player's own pieces, we should instead do that within the
-      // check_move_validity().
-      if (check_move_validity(game, game->selected_piece, p) &&
-	  (!eating_piece || (eating_piece && !SAME_PLAYER(eating_piece, game->selected_piece)))) {
-	add_valid_move(game, p);
+      const Piece *p = game->board[x][y];
+      if (p) {
+	key ^= ZOBRIST_PIECES[p->type][y * BOARD_WIDTH + x];
       }
     }
   }
 
-  return;
+  return key;
+}
+
+// Forgets every position reached so far, the current one becomes the
+// first of the history. This must be called whenever the board is
+// set up without playing moves.
+void reset_history(Game *game, int halfmove_clock) {
+  game->key = compute_position_key(game);
+  game->ply = 0;
+  game->history[0] = game->key;
+  game->halfmove_clock = halfmove_clock;
+}
+
+// Returns how many times the current position has already been
+// reached. Only positions with the same player to move reached after
+// the last capture or pawn move are looked at, since the ones before
+// can not be repeated.
+int count_repetitions(const Game *game) {
+  int limit = game->halfmove_clock;
+  if (limit > game->ply) {
+    limit = game->ply;
+  }
+  if (limit > GAME_HISTORY_SIZE - 1) {
+    limit = GAME_HISTORY_SIZE - 1;
+  }
+
+  int count = 0;
+
+  // it takes at least 4 plies to get back to the same position
+  for (int i = 4; i <= limit; i += 2) {
+    if (game->history[(game->ply - i) & (GAME_HISTORY_SIZE - 1)] == game->key) {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+// Only bare kings are a dead draw: since a king with no safe square
+// must still move, and be eaten, a single knight or bishop can win
+// (see the KNvK and KBvK endgame tables). Bare kings standing next to
+// each other are not a draw either, the side to move eats the other
+// king.
+static int insufficient_material(const Game *game) {
+  int kings[2], kings_count = 0;
+
+  for (int x = 0; x < BOARD_WIDTH; x++) {
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+      const Piece *p = game->board[x][y];
+      if (!p) {
+	continue;
+      }
+      if ((p->type != B_KING && p->type != W_KING) || kings_count == 2) {
+	return 0;
+      }
+      kings[kings_count++] = SQUARE(p->pos);
+    }
+  }
+
+  return kings_count == 2 && !(KING_ATTACKS[kings[0]] & SQUARE_BIT(kings[1]));
+}
+
+// Tells whether the current position is a draw, and why.
+DrawReason check_draw(const Game *game) {
+  if (insufficient_material(game)) {
+    return DRAW_INSUFFICIENT_MATERIAL;
+  }
+
+  if (game->halfmove_clock >= FIFTY_MOVES_PLIES) {
+    return DRAW_FIFTY_MOVES;
+  }
+
+  // threefold repetition: the current position plus two earlier ones
+  if (count_repetitions(game) >= 2) {
+    return DRAW_REPETITION;
+  }
+
+  return DRAW_NONE;
+}
+
+const char *draw_reason_name(DrawReason r) {
+  switch(r) {
+  case DRAW_REPETITION:            return "REPETITION";
+  case DRAW_FIFTY_MOVES:           return "FIFTY_MOVES";
+  case DRAW_INSUFFICIENT_MATERIAL: return "INSUFFICIENT_MATERIAL";
+  default:                         return "NONE";
+  }
+}
+
+// ----------
+
+// Collects every move the selected player can do in `moves`, which
+// can hold up to `max_moves` elements.
+//
+// Returns the number of moves found.
+int generate_moves(Game *game, Move *moves, int max_moves) {
+  int count = 0;
+
+  for (int x = 0; x < BOARD_WIDTH; x++) {
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+      Piece *p = game->board[x][y];
+      if (!p || !OWNED_BY_PLAYER(game, p)) {
+	continue;
+      }
+
+      uint64_t candidates = candidate_squares(p);
+
+      while (candidates) {
+	int sq = __builtin_ctzll(candidates);
+	candidates &= candidates - 1;
+
+	Pos new_pos = (Pos) {.x = sq % BOARD_WIDTH, .y = sq / BOARD_WIDTH};
+	Piece *eating_piece = game->board[new_pos.x][new_pos.y];
+
+	if ((eating_piece && SAME_PLAYER(eating_piece, p)) ||
+	    !check_move_validity(game, p, new_pos)) {
+	  continue;
+	}
+
+	if (count >= max_moves) {
+	  return count;
+	}
+	moves[count++] = (Move) {.start = p->pos, .end = new_pos};
+      }
+    }
+  }
+
+  return count;
+}
+
+// Does the move `m` without touching scores nor freeing the eaten
+// piece, so that it can be taken back with unmake_move(). This is
+// what the engine uses while searching.
+void make_move(Game *game, Move m, Undo *u) {
+  Piece *p = game->board[m.start.x][m.start.y];
+  assert(p && "make_move() needs a piece on the starting square!");
+
+  u->move = m;
+  u->captured = game->board[m.end.x][m.end.y];
+  u->key = game->key;
+  u->halfmove_clock = game->halfmove_clock;
+
+  game->board[m.start.x][m.start.y] = NULL;
+  game->board[m.end.x][m.end.y] = p;
+  p->pos = m.end;
+
+  game->selected_player = IS_PLAYER_WHITE(game) ? &game->b_player : &game->w_player;
+
+  push_position(game, p->type, m.start, m.end, u->captured, 1);
+}
+
+void unmake_move(Game *game, const Undo *u) {
+  Move m = u->move;
+  Piece *p = game->board[m.end.x][m.end.y];
+
+  game->board[m.start.x][m.start.y] = p;
+  game->board[m.end.x][m.end.y] = u->captured;
+  p->pos = m.start;
+
+  game->selected_player = IS_PLAYER_WHITE(game) ? &game->b_player : &game->w_player;
+
+  game->key = u->key;
+  game->halfmove_clock = u->halfmove_clock;
+  game->ply--;
 }
@@ -0,0 +1,165 @@
+/*
+  Generates the move and attack tables, and the Zobrist keys, declared
+  in include/tables.h.
+
+    ./gentables tables.c
+
+  This is run by the Makefile before building anything that uses the
+  tables, the generated file is not meant to be edited.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "./include/game.h"
+#include "./include/tables.h"
+
+// one step in every direction, in the same order as Dir.
+static const int DIR_DX[STILL] = { 0, 0, -1, 1, -1, -1, 1, 1 };
+static const int DIR_DY[STILL] = { -1, 1, 0, 0, -1, 1, -1, 1 };
+
+static uint64_t knight_attacks[SQUARES_COUNT];
+static uint64_t king_attacks[SQUARES_COUNT];
+static uint64_t pawn_attacks[2][SQUARES_COUNT];
+static uint64_t pawn_pushes[2][SQUARES_COUNT];
+static uint64_t rook_attacks[SQUARES_COUNT];
+static uint64_t bishop_attacks[SQUARES_COUNT];
+static uint64_t between[SQUARES_COUNT][SQUARES_COUNT];
+static uint64_t zobrist_pieces[EMPTY][SQUARES_COUNT];
+static uint64_t zobrist_w_to_move;
+
+// keys are always the same, so that they can be stored.
+#define ZOBRIST_SEED 0x43484553534b4559ULL
+
+// ----------------------------------------
+
+// Returns the bit of square (x, y), or 0 if it is out of the board.
+//
+// NOTE: out_of_board_pos() is not used here, game.c needs the tables
+// to be built.
+static uint64_t square_bit(int x, int y) {
+  if (x < 0 || x >= BOARD_WIDTH || y < 0 || y >= BOARD_HEIGHT) {
+    return 0;
+  }
+  return SQUARE_BIT(y * BOARD_WIDTH + x);
+}
+
+static void compute_tables(void) {
+  static const int KNIGHT_DX[8] = { 1, 2, 2, 1, -1, -2, -2, -1 };
+  static const int KNIGHT_DY[8] = { -2, -1, 1, 2, 2, 1, -1, -2 };
+
+  // squares reached from a square going in each direction.
+  uint64_t rays[STILL];
+
+  for (int y = 0; y < BOARD_HEIGHT; y++) {
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+      int sq = y * BOARD_WIDTH + x;
+
+      for (int i = 0; i < 8; i++) {
+	knight_attacks[sq] |= square_bit(x + KNIGHT_DX[i], y + KNIGHT_DY[i]);
+	king_attacks[sq] |= square_bit(x + DIR_DX[i], y + DIR_DY[i]);
+      }
+
+      // black pawns go down the board, white pawns go up.
+      pawn_attacks[TABLE_BLACK][sq] = square_bit(x - 1, y + 1) | square_bit(x + 1, y + 1);
+      pawn_attacks[TABLE_WHITE][sq] = square_bit(x - 1, y - 1) | square_bit(x + 1, y - 1);
+      pawn_pushes[TABLE_BLACK][sq] = square_bit(x, y + 1) | (y == 1 ? square_bit(x, y + 2) : 0);
+      pawn_pushes[TABLE_WHITE][sq] = square_bit(x, y - 1) | (y == 6 ? square_bit(x, y - 2) : 0);
+
+      for (int d = 0; d < STILL; d++) {
+	uint64_t seen = 0;
+
+	for (int nx = x + DIR_DX[d], ny = y + DIR_DY[d]; square_bit(nx, ny); nx += DIR_DX[d], ny += DIR_DY[d]) {
+	  int to = ny * BOARD_WIDTH + nx;
+	  between[sq][to] = seen;
+	  seen |= SQUARE_BIT(to);
+	}
+	rays[d] = seen;
+      }
+
+      rook_attacks[sq] = rays[UP] | rays[DOWN] | rays[LEFT] | rays[RIGHT];
+      bishop_attacks[sq] = rays[DIAG_LU] | rays[DIAG_LD] | rays[DIAG_RU] | rays[DIAG_RD];
+    }
+  }
+}
+
+// splitmix64, see https://prng.di.unimi.it/splitmix64.c
+static uint64_t next_random(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void compute_zobrist(void) {
+  uint64_t state = ZOBRIST_SEED;
+
+  for (int t = 0; t < EMPTY; t++) {
+    for (int sq = 0; sq < SQUARES_COUNT; sq++) {
+      zobrist_pieces[t][sq] = next_random(&state);
+    }
+  }
+  zobrist_w_to_move = next_random(&state);
+}
+
+// ----------------------------------------
+
+static void emit_values(FILE *f, const uint64_t *values, int count, const char *indent) {
+  for (int i = 0; i < count; i++) {
+    fprintf(f, "%s0x%016llxULL,%s", i % 4 ? "" : indent,
+	    (unsigned long long) values[i], i % 4 == 3 || i == count - 1 ? "\n" : " ");
+  }
+}
+
+static void emit_table(FILE *f, const char *name, const uint64_t *values) {
+  fprintf(f, "\nconst uint64_t %s[SQUARES_COUNT] = {\n", name);
+  emit_values(f, values, SQUARES_COUNT, "  ");
+  fprintf(f, "};\n");
+}
+
+static void emit_table2(FILE *f, const char *name, const char *rows, int rows_count, const uint64_t *values) {
+  fprintf(f, "\nconst uint64_t %s[%s][SQUARES_COUNT] = {\n", name, rows);
+  for (int r = 0; r < rows_count; r++) {
+    fprintf(f, "  {\n");
+    emit_values(f, values + r * SQUARES_COUNT, SQUARES_COUNT, "    ");
+    fprintf(f, "  },\n");
+  }
+  fprintf(f, "};\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s tables.c\n", argv[0]);
+    return 1;
+  }
+
+  FILE *f = fopen(argv[1], "w");
+  if (!f) {
+    fprintf(stderr, "[ERROR] - Could not open %s\n", argv[1]);
+    return 1;
+  }
+
+  compute_tables();
+  compute_zobrist();
+
+  fprintf(f, "// Generated by gentables.c, do not edit.\n\n");
+  fprintf(f, "#include \"./include/tables.h\"\n");
+
+  emit_table(f, "KNIGHT_ATTACKS", knight_attacks);
+  emit_table(f, "KING_ATTACKS", king_attacks);
+  emit_table2(f, "PAWN_ATTACKS", "2", 2, &pawn_attacks[0][0]);
+  emit_table2(f, "PAWN_PUSHES", "2", 2, &pawn_pushes[0][0]);
+  emit_table(f, "ROOK_ATTACKS", rook_attacks);
+  emit_table(f, "BISHOP_ATTACKS", bishop_attacks);
+  emit_table2(f, "BETWEEN", "SQUARES_COUNT", SQUARES_COUNT, &between[0][0]);
+  emit_table2(f, "ZOBRIST_PIECES", "EMPTY", EMPTY, &zobrist_pieces[0][0]);
+  fprintf(f, "\nconst uint64_t ZOBRIST_W_TO_MOVE = 0x%016llxULL;\n", (unsigned long long) zobrist_w_to_move);
+
+  if (fclose(f) != 0) {
+    fprintf(stderr, "[ERROR] - Could not write %s\n", argv[1]);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ----------------------------------------
+// Linear allocator: a single block of memory from which objects are
+// carved one after the other. Objects are never freed one by one, the
+// whole arena is reset at once.
+
+#define ARENA_ALIGNMENT 16
+
+typedef struct {
+  uint8_t *base;
+  size_t capacity;
+  size_t used;
+} Arena;
+
+// ----------------------------------------
+// DECLARATIONS
+
+int arena_init(Arena *a, size_t capacity);
+void *arena_alloc(Arena *a, size_t size);
+void arena_reset(Arena *a);
+void arena_destroy(Arena *a);
+
+#endif // ARENA_H_
@@ -0,0 +1,42 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "./game.h"
+#include "./record.h"
+
+// ----------------------------------------
+// Move generation for many independent positions at once.
+//
+// Positions are split in chunks of BATCH_CHUNK_SIZE, which are handed
+// out to the worker threads. Every worker starts with an even share of
+// the chunks and, once done with them, steals half of what is left to
+// the other workers.
+//
+// The moves of position i end up in
+//
+//   moves[offsets[i]] ... moves[offsets[i + 1] - 1]
+//
+// Positions are not checked: every one of them must pass
+// record_is_valid(), as the ones returned by record_positions() do.
+
+#define BATCH_CHUNK_SIZE 256
+#define BATCH_MAX_THREADS 64
+
+typedef struct {
+  PackedMove *moves;
+  size_t *offsets;
+
+  size_t positions_count;
+  size_t moves_count;
+} MoveBatch;
+
+// ----------------------------------------
+// DECLARATIONS
+
+int batch_generate_moves(const PosRecord *positions, size_t count, int threads, MoveBatch *out);
+void batch_free(MoveBatch *batch);
+
+#endif // BATCH_H_
@@ -0,0 +1,46 @@
+#ifndef BOOK_H_
+#define BOOK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "./game.h"
+
+// ----------------------------------------
+// Polyglot opening books.
+//
+// A Polyglot .bin file is a sequence of 16 bytes big-endian entries
+// sorted by key. The file is mapped in memory and probed with a binary
+// search, there is no load step.
+//
+// The key of a position is computed with the 781 standard Polyglot
+// Random64 numbers. Since black moves first in this game, positions
+// are mirrored before being looked up (see book_key()).
+
+#define POLYGLOT_KEYS_COUNT 781
+
+// key of the standard starting position with white to move, which is
+// also the key of DEFAULT_BOARD with black to move.
+#define POLYGLOT_START_KEY 0x463B96181691FC9CULL
+
+typedef enum {
+  BOOK_SELECT_BEST = 0,
+  BOOK_SELECT_WEIGHTED,
+} BookSelect;
+
+typedef struct {
+  const uint8_t *base;
+  size_t size;
+  size_t entries_count;
+} Book;
+
+// ----------------------------------------
+// DECLARATIONS
+
+int book_open(Book *book, const char *book_path);
+void book_close(Book *book);
+
+uint64_t book_key(const Game *game);
+int book_probe(const Book *book, Game *game, BookSelect select, Move *out);
+
+#endif // BOOK_H_
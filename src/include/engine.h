@@ -0,0 +1,33 @@
+#ifndef ENGINE_H_
+#define ENGINE_H_
+
+#include "./game.h"
+#include "./book.h"
+#include "./tb.h"
+
+// score of a position in which the king can be captured.
+#define MATE_SCORE 100000
+
+// score of a position won according to the endgame tables.
+#define TABLEBASE_WIN_SCORE (MATE_SCORE - 1000)
+
+#define DEFAULT_SEARCH_DEPTH 3
+
+typedef struct {
+  int depth;
+
+  // optional, NULL if no opening book should be used.
+  const Book *book;
+  BookSelect book_select;
+
+  long nodes;
+} Engine;
+
+// ----------------------------------------
+// DECLARATIONS
+
+int evaluate(const Game *game);
+int search(Engine *e, Game *game, int depth, int ply, int alpha, int beta);
+int engine_pick_move(Engine *e, Game *game, Move *out);
+
+#endif // ENGINE_H_
@@ -0,0 +1,28 @@
+#ifndef FUZZ_H_
+#define FUZZ_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ----------------------------------------
+// Fuzz targets follow the libFuzzer interface: the same source is
+// linked either with -fsanitize=fuzzer, or with fuzz_main.c which
+// runs the target on files (or on stdin, as AFL does).
+//
+// A target aborts when it finds a bug, so that every fuzzer sees it
+// as a crash.
+
+// longest input, in bytes, looked at by the targets.
+#define FUZZ_MAX_INPUT 4096
+
+#define FUZZ_CHECK(cond)						\
+  do {									\
+    if (!(cond)) {							\
+      fprintf(stderr, "[ERROR] - %s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      abort();								\
+    }									\
+  } while (0)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#endif // FUZZ_H_
@@ -1,8 +1,7 @@
 #ifndef GAME_H_
 #define GAME_H_
 
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
+#include <stdint.h>
 
 #define SCREEN_WIDTH  600
 #define SCREEN_HEIGHT 600
@@ -17,6 +16,20 @@
 // at any given time.
 #define MAX_VALID_MOVES (BOARD_WIDTH * 4)
 
+// represents maximum amount of different moves a player can do at
+// any given time.
+#define MAX_MOVES 256
+
+// represents maximum amount of pieces on the board.
+#define MAX_PIECES 32
+
+// represents how many position keys a game remembers, it must be a
+// power of two larger than FIFTY_MOVES_PLIES.
+#define GAME_HISTORY_SIZE 256
+
+// plies without captures nor pawn moves after which the game is drawn.
+#define FIFTY_MOVES_PLIES 100
+
 #define B_PLAYER_NAME "BLACK"
 #define W_PLAYER_NAME "WHITE"
 
@@ -56,28 +69,43 @@ typedef enum {
   STILL,
 } Dir;
 
+typedef enum {
+  DRAW_NONE = 0,
+  DRAW_REPETITION,
+  DRAW_FIFTY_MOVES,
+  DRAW_INSUFFICIENT_MATERIAL,
+} DrawReason;
+
 typedef struct {
   int x;
   int y;
 } Pos;
 
+typedef struct {
+  Pos start;
+  Pos end;
+} Move;
+
 typedef struct {
   PieceType type;
   Pos pos;
   const char *image_path;
-
-  SDL_Surface *image;
-  SDL_Texture *texture;
 } Piece;
 
 typedef struct {
-  PieceType score[16];
+  // a player can eat at most every piece but the enemy king.
+  PieceType score[MAX_PIECES];
   int score_count;
   char *player_name;
 } Player;
 
 typedef struct {
   Piece *board[BOARD_WIDTH][BOARD_HEIGHT];
+
+  // every piece of the game lives here, the board only points to
+  // them. Eaten pieces stay in the pool until the game is reset.
+  Piece pieces[MAX_PIECES];
+  int pieces_count;
   
   // NOTE: at most a piece can move in <= 8 * 4 = 32 different positions
   Pos valid_moves[MAX_VALID_MOVES];
@@ -88,32 +116,72 @@ typedef struct {
 
   Piece *selected_piece;
   Player *selected_player;
+
+  // Zobrist key of the current position. The keys of the positions
+  // reached so far are kept in a ring, the current one being
+  // history[ply % GAME_HISTORY_SIZE].
+  uint64_t key;
+  uint64_t history[GAME_HISTORY_SIZE];
+  int ply;
+
+  // plies played before the first position of the history, when the
+  // game was set up from a record. Used for the move number.
+  int start_ply;
+
+  // plies since the last capture or pawn move, positions before that
+  // can never be repeated.
+  int halfmove_clock;
   
   int quit;
 } Game;
 
+// Everything needed by unmake_move() to take back a move done with
+// make_move().
+typedef struct {
+  Move move;
+  Piece *captured;
+
+  uint64_t key;
+  int halfmove_clock;
+} Undo;
+
 // ----------------------------------------
 // DECLARATIONS
 
+extern const PieceType DEFAULT_BOARD[BOARD_HEIGHT][BOARD_WIDTH];
+
 const char *type2png(PieceType t);
 
 void init_game(Game *game);
 void destroy_game(Game *game);
 
-Piece *init_piece(PieceType t, Pos init_pos);
+Piece *init_piece(Game *game, PieceType t, Pos init_pos);
 void update_selected_piece(Game *game, Pos p);
-void destroy_piece(Piece *p);
 
 int check_move_validity(Game *game, Piece *p, Pos new_pos);
 int move_piece(Game *game, Piece *p, Pos new_pos);
-Dir compute_movement_dir(Pos start_pos, Pos end_pos);
 int out_of_board_pos(Pos pos);
-int check_obstacles_in_path(Game *game, Pos start_pos, Pos end_pos, Dir dir);
+int check_obstacles_in_path(Game *game, Pos start_pos, Pos end_pos);
 
 void update_player_score(Player *p, PieceType t);
 
 void update_valid_moves(Game *game);
-void add_valid_move(Game *game, Pos new_pos);
+int add_valid_move(Game *game, Pos new_pos);
+
+int validate_move(Game *game, Move m);
+
+int parse_move(const char *s, Move *m);
+void format_move(Move m, char *s);
+
+uint64_t compute_position_key(const Game *game);
+void reset_history(Game *game, int halfmove_clock);
+int count_repetitions(const Game *game);
+DrawReason check_draw(const Game *game);
+const char *draw_reason_name(DrawReason r);
+
+int generate_moves(Game *game, Move *moves, int max_moves);
+void make_move(Game *game, Move m, Undo *u);
+void unmake_move(Game *game, const Undo *u);
 
 // ----------------------------------------
 // UTILS MACRO
@@ -124,6 +192,8 @@ void add_valid_move(Game *game, Pos new_pos);
 #define IS_PLAYER_BLACK(g) (g->selected_player == &g->b_player)
 #define IS_PLAYER_WHITE(g) (g->selected_player == &g->w_player)
 
+#define OWNED_BY_PLAYER(g, p) ((IS_PIECE_BLACK(p->type) && IS_PLAYER_BLACK(g)) || (IS_PIECE_WHITE(p->type) && IS_PLAYER_WHITE(g)))
+
 #define SAME_PLAYER(p1, p2) ((IS_PIECE_BLACK(p1->type) && IS_PIECE_BLACK(p2->type)) || (IS_PIECE_WHITE(p1->type) && IS_PIECE_WHITE(p2->type)))
 
 #endif // GAME_H_
@@ -0,0 +1,128 @@
+#ifndef RECORD_H_
+#define RECORD_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "./game.h"
+
+// ----------------------------------------
+// Compact binary format for positions and games.
+//
+// A record file starts with a RecordFileHeader, followed either by a
+// sequence of PosRecord (RECORD_KIND_POSITIONS) or by a sequence of
+// games (RECORD_KIND_GAMES). Every game is a GameRecordHeader followed
+// by `move_count` packed moves, padded to a multiple of 8 bytes so
+// that the next game stays aligned inside the mapped file.
+//
+// Squares are indexed as (y * BOARD_WIDTH + x), which means that
+// square 0 is the top-left corner of the board (a8) and square 63 is
+// the bottom-right one (h1). This is the same order in which a FEN
+// string lists the board.
+//
+// NOTE: fields are written in host byte order, files are therefore
+// only portable between little-endian machines.
+
+#define RECORD_MAGIC "CHRC"
+#define RECORD_VERSION 1
+
+#define FEN_MAX_LEN 128
+
+typedef enum {
+  RECORD_KIND_POSITIONS = 0,
+  RECORD_KIND_GAMES,
+} RecordKind;
+
+typedef enum {
+  RECORD_RESULT_UNKNOWN = 0,
+  RECORD_RESULT_B_WON,
+  RECORD_RESULT_W_WON,
+  RECORD_RESULT_DRAW,
+} RecordResult;
+
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t kind;
+  uint64_t count;
+} RecordFileHeader;
+
+// 32 bytes per position.
+typedef struct {
+  // bit (y * BOARD_WIDTH + x) is set if a piece stands on that square.
+  uint64_t occupancy;
+  // PieceType of every occupied square, two per byte (low nibble
+  // first), in the same order as the bits of `occupancy`.
+  uint8_t pieces[16];
+
+  uint8_t w_to_move;
+  uint8_t flags;
+  uint16_t halfmove_clock;
+  uint16_t fullmove_number;
+  uint16_t reserved;
+} PosRecord;
+
+typedef struct {
+  PosRecord start;
+  uint16_t move_count;
+  uint8_t result;
+  uint8_t reserved[5];
+} GameRecordHeader;
+
+// bits 0-5 contain the starting square, bits 6-11 the ending one.
+typedef uint16_t PackedMove;
+
+typedef struct {
+  FILE *fp;
+  RecordKind kind;
+  uint64_t count;
+} RecordWriter;
+
+typedef struct {
+  const uint8_t *base;
+  size_t size;
+  size_t offset;
+
+  RecordKind kind;
+  uint64_t count;
+
+  // invalid records found so far, they are never returned.
+  uint64_t skipped;
+} RecordReader;
+
+typedef struct {
+  const GameRecordHeader *header;
+  const PackedMove *moves;
+} GameView;
+
+// ----------------------------------------
+// DECLARATIONS
+
+PackedMove pack_move(Pos start_pos, Pos end_pos);
+Pos packed_move_start(PackedMove m);
+Pos packed_move_end(PackedMove m);
+
+PieceType record_piece_at(const PosRecord *r, int square);
+int record_is_valid(const PosRecord *r);
+
+int fen_to_record(const char *fen, PosRecord *r);
+void record_to_fen(const PosRecord *r, char *fen, size_t size);
+
+void record_from_game(PosRecord *r, const Game *game);
+void record_to_game(const PosRecord *r, Game *game);
+void record_load_board(const PosRecord *r, Game *game);
+
+int record_writer_open(RecordWriter *w, const char *path, RecordKind kind);
+int record_write_position(RecordWriter *w, const PosRecord *r);
+int record_write_game(RecordWriter *w, const PosRecord *start,
+		      const PackedMove *moves, uint16_t move_count, RecordResult result);
+int record_writer_close(RecordWriter *w);
+
+int record_reader_open(RecordReader *r, const char *path);
+const PosRecord *record_next_position(RecordReader *r);
+const PosRecord *record_positions(const RecordReader *r, size_t *count);
+int record_next_game(RecordReader *r, GameView *view);
+void record_reader_close(RecordReader *r);
+
+#endif // RECORD_H_
@@ -36,5 +36,6 @@ void render_piece(SDL_Renderer *renderer, Piece *p, int selected);
 void render_board(SDL_Renderer *renderer);
 void render_pos_highlight(SDL_Renderer *renderer, Pos p, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 void render_valid_moves(SDL_Renderer *renderer, const Game *game);
+void destroy_piece_textures(void);
 
 #endif // RENDER_H_
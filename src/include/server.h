@@ -0,0 +1,82 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "./game.h"
+#include "./session.h"
+
+// ----------------------------------------
+// Line based protocol spoken by the server. Every request is a single
+// line, and gets a single line back, either "OK <id> ..." or
+// "ERR <id|-> <reason>":
+//
+//   NEW                  OK <id>
+//   MOVE <id> <e7e5>     OK <id> <e7e5> <status>
+//   MOVES <id>           OK <id> <move> <move> ...
+//   FEN <id>             OK <id> <fen>
+//   WATCH <id>           OK <id> <fen>
+//   UNWATCH <id>         OK <id>
+//   RESET <id>           OK <id>           (starts a new game)
+//   CLOSE <id>           OK <id>
+//
+// A session belongs to the connection that created it, and is closed
+// together with it. Other connections can WATCH a session (watching it
+// again changes nothing) until they UNWATCH it or disconnect. Every
+// move played on it is then pushed to them as
+//
+//   UPDATE <id> <e7e5> <status>
+//
+// and every new game started by RESET as
+//
+//   RESET <id> <fen>
+//
+// where status is ONGOING, WON <player> or DRAW <reason> (REPETITION,
+// FIFTY_MOVES or INSUFFICIENT_MATERIAL). Once a game is over it only
+// accepts RESET and CLOSE. A session records at most
+// SESSION_HISTORY_CAPACITY plies, moves past that get
+// "ERR <id> history is full".
+
+#define SERVER_DEFAULT_PORT 5555
+#define SERVER_DEFAULT_SESSIONS 16384
+#define SERVER_MAX_WATCHERS 4
+#define SERVER_MAX_LINE 256
+
+// a connection whose pending output grows past this is dropped.
+#define SERVER_MAX_OUTPUT (1 << 20)
+
+// a connection, identified by its file descriptor and by a counter
+// that is never reused (file descriptors are).
+typedef struct {
+  int fd;
+  uint64_t id;
+} ConnRef;
+
+typedef struct {
+  Session session;
+  int initialized;
+  int in_use;
+  int finished;
+
+  ConnRef owner;
+  ConnRef watchers[SERVER_MAX_WATCHERS];
+  int watchers_count;
+} ServerSession;
+
+typedef struct {
+  int fd;
+  uint64_t id;
+
+  char in[SERVER_MAX_LINE * 16];
+  size_t in_len;
+
+  char *out;
+  size_t out_len;
+  size_t out_capacity;
+  int want_write;
+
+  int sessions_count;
+} Conn;
+
+#endif // SERVER_H_
@@ -0,0 +1,47 @@
+#ifndef SESSION_H_
+#define SESSION_H_
+
+#include "./game.h"
+#include "./arena.h"
+#include "./record.h"
+
+// ----------------------------------------
+// A session is a single game together with everything needed to play
+// and analyse it. All of it is carved from one arena allocated when
+// the session is created: no memory is allocated while playing, and
+// resetting the session does not depend on how long the game was.
+
+// maximum number of plies a session can record.
+#define SESSION_HISTORY_CAPACITY 1024
+
+// errors returned by session_play().
+#define SESSION_ILLEGAL_MOVE (-1)
+#define SESSION_HISTORY_FULL (-2)
+
+typedef struct {
+  Arena arena;
+
+  Game *game;
+
+  // moves played so far, in the same format used by game records.
+  PackedMove *history;
+  int history_count;
+
+  // moves of the selected player, refreshed by session_update_moves().
+  Move *moves;
+  int moves_count;
+} Session;
+
+// ----------------------------------------
+// DECLARATIONS
+
+size_t session_footprint(void);
+
+int session_init(Session *s);
+void session_reset(Session *s);
+void session_destroy(Session *s);
+
+int session_play(Session *s, Move m);
+void session_update_moves(Session *s);
+
+#endif // SESSION_H_
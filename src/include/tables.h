@@ -0,0 +1,46 @@
+#ifndef TABLES_H_
+#define TABLES_H_
+
+#include <stdint.h>
+
+#include "./game.h"
+
+// ----------------------------------------
+// Move and attack tables. They are computed at build time by
+// gentables.c, which writes tables.c, so they are plain const data:
+// nothing is initialized at startup.
+//
+// Squares are indexed as y * BOARD_WIDTH + x (the same order used by
+// records), and every table is a set of squares, one bit per square.
+
+#define SQUARES_COUNT (BOARD_WIDTH * BOARD_HEIGHT)
+
+#define SQUARE(p) ((p).y * BOARD_WIDTH + (p).x)
+#define SQUARE_BIT(s) ((uint64_t) 1 << (s))
+
+// side index of the pawn tables.
+#define TABLE_BLACK 0
+#define TABLE_WHITE 1
+
+extern const uint64_t KNIGHT_ATTACKS[SQUARES_COUNT];
+extern const uint64_t KING_ATTACKS[SQUARES_COUNT];
+
+// squares a pawn captures on, and squares it can be pushed to (two of
+// them from its starting row).
+extern const uint64_t PAWN_ATTACKS[2][SQUARES_COUNT];
+extern const uint64_t PAWN_PUSHES[2][SQUARES_COUNT];
+
+// squares reached by rooks and bishops on an empty board.
+extern const uint64_t ROOK_ATTACKS[SQUARES_COUNT];
+extern const uint64_t BISHOP_ATTACKS[SQUARES_COUNT];
+
+// squares strictly between two squares on the same row, column or
+// diagonal, empty if the squares are not aligned.
+extern const uint64_t BETWEEN[SQUARES_COUNT][SQUARES_COUNT];
+
+// Zobrist keys: the key of a position is the xor of the key of every
+// piece on its square, and of ZOBRIST_W_TO_MOVE if white is to move.
+extern const uint64_t ZOBRIST_PIECES[EMPTY][SQUARES_COUNT];
+extern const uint64_t ZOBRIST_W_TO_MOVE;
+
+#endif // TABLES_H_
@@ -0,0 +1,98 @@
+#ifndef TB_H_
+#define TB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "./game.h"
+
+// ----------------------------------------
+// Endgame tablebases.
+//
+// Every material combination is stored in its own file named after
+// it, white pieces first (e.g. KQvK.ctb is white king and queen
+// against the black king). Positions with colors swapped are looked
+// up in the mirrored file, so KvKQ is answered by KQvK.ctb.
+//
+// A file is a TbFileHeader followed by one byte per position, which
+// tells whether the side to move wins, loses or draws, and in how
+// many plies the king gets captured. The index of a position is
+//
+//   side * 64^n + sq_0 * 64^0 + ... + sq_(n-1) * 64^(n-1)
+//
+// where side is 1 if white is to move, n is the number of pieces and
+// sq_i is the square (y * BOARD_WIDTH + x) of the i-th piece, in the
+// order given by the file name.
+//
+// Files are generated by tbgen following the rules of this game
+// (e.g. no promotion, the game ends when a king is eaten), and mapped
+// lazily the first time a position with their material is probed.
+//
+// NOTE: the index is not reduced by symmetry nor by the placement of
+// the kings, so a table takes 2 * 64^n bytes: 32 MiB with four pieces
+// but 2 GiB with five. Tables are therefore limited to TB_MAX_PIECES
+// pieces, five-piece tables are out of scope for this format.
+
+#define TB_MAGIC "CHTB"
+#define TB_VERSION 1
+#define TB_EXTENSION ".ctb"
+
+#define TB_MAX_PIECES 4
+#define TB_NAME_LEN 16
+#define TB_MAX_TABLES 128
+
+// encoding of a single entry.
+#define TB_VALUE_DRAW 0
+#define TB_VALUE_WIN(d) ((uint8_t) (d))
+#define TB_VALUE_LOSS(d) ((uint8_t) (128 + (d)))
+#define TB_VALUE_IS_WIN(v) ((v) > 0 && (v) < 128)
+#define TB_VALUE_IS_LOSS(v) ((v) > 128)
+#define TB_VALUE_DISTANCE(v) ((v) & 0x7F)
+#define TB_MAX_DISTANCE 127
+
+typedef enum {
+  TB_LOSS = 0,
+  TB_DRAW,
+  TB_WIN,
+  TB_FAILED,
+} TbWdl;
+
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t pieces_count;
+  char name[TB_NAME_LEN];
+  uint8_t reserved[8];
+} TbFileHeader;
+
+typedef struct {
+  char name[TB_NAME_LEN];
+  size_t index;
+  int pieces_count;
+} TbKey;
+
+// probes are only counted for positions with at most TB_MAX_PIECES
+// pieces and both kings.
+typedef struct {
+  long wdl_probes;
+  long wdl_hits;
+  long root_probes;
+  long root_hits;
+  int tables_mapped;
+} TbStats;
+
+extern TbStats TB_STATS;
+
+// ----------------------------------------
+// DECLARATIONS
+
+void tb_init(const char *path);
+void tb_free(void);
+
+int tb_compute_key(const Game *game, int mirror, TbKey *key);
+int tb_probe_value(const Game *game, uint8_t *value);
+
+TbWdl tb_probe_wdl(const Game *game);
+int tb_probe_root(Game *game, Move *out, TbWdl *wdl, int *distance);
+
+#endif // TB_H_
@@ -0,0 +1,437 @@
+/*
+  Load generator for the game server.
+
+    ./loadgen [-p port | -u socket_path] [-c connections] [-s sessions] [-t seconds]
+
+  Opens `sessions` games spread over `connections` connections and
+  keeps every one of them busy: each session always has one MOVE in
+  flight, picked at random among the legal moves of a local copy of
+  the game. Finished games are RESET and played again. At the end the
+  throughput and the latency distribution of the moves are reported.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "./include/game.h"
+#include "./include/server.h"
+
+#define DEFAULT_CONNECTIONS 16
+#define DEFAULT_SESSIONS 10000
+#define DEFAULT_SECONDS 10
+
+// latencies are bucketed by microsecond, up to one second.
+#define HISTOGRAM_SIZE 1000000
+
+typedef struct {
+  int id;
+  Game game;
+  Move pending;
+} ClientSession;
+
+typedef struct {
+  int fd;
+
+  ClientSession *sessions;
+  int sessions_count;
+
+  // requests in flight, answered by the server in order.
+  int *queue_session;
+  uint64_t *queue_sent;
+  int queue_head;
+  int queue_len;
+
+  char in[SERVER_MAX_LINE * 16];
+  size_t in_len;
+
+  char *out;
+  size_t out_len;
+  size_t out_capacity;
+  int want_write;
+} Client;
+
+// ----------------------------------------
+// GLOBAL VARIABLES
+
+static uint64_t *HISTOGRAM = NULL;
+static uint64_t MAX_LATENCY = 0;
+static long MOVES_DONE = 0;
+static long GAMES_DONE = 0;
+static long ERRORS = 0;
+
+static int EPOLL_FD = -1;
+
+// ----------------------------------------
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int connect_server(int port, const char *unix_path) {
+  int fd;
+
+  if (unix_path) {
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", unix_path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+      perror("[ERROR] - connect");
+      return -1;
+    }
+  } else {
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t) port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+      perror("[ERROR] - connect");
+      return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+
+  return fd;
+}
+
+static void update_events(Client *c) {
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN | (c->want_write ? EPOLLOUT : 0);
+  ev.data.ptr = c;
+  epoll_ctl(EPOLL_FD, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+// Queues a request on `c`, whose answer will be matched to `session`.
+static void send_request(Client *c, int session, const char *fmt, ...) {
+  char line[SERVER_MAX_LINE];
+
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+
+  if (c->out_len + len > c->out_capacity) {
+    c->out_capacity = c->out_capacity ? c->out_capacity * 2 : 4096;
+    c->out = realloc(c->out, c->out_capacity);
+    if (!c->out) {
+      fprintf(stderr, "[ERROR] - Could not allocate output buffer\n");
+      exit(1);
+    }
+  }
+  memcpy(c->out + c->out_len, line, len);
+  c->out_len += len;
+
+  int tail = (c->queue_head + c->queue_len) % (c->sessions_count + 1);
+  c->queue_session[tail] = session;
+  c->queue_sent[tail] = now_us();
+  c->queue_len++;
+}
+
+static void flush_client(Client *c) {
+  size_t written = 0;
+
+  while (written < c->out_len) {
+    ssize_t n = write(c->fd, c->out + written, c->out_len - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (n <= 0) {
+      fprintf(stderr, "[ERROR] - Lost connection to the server\n");
+      exit(1);
+    }
+    written += n;
+  }
+
+  memmove(c->out, c->out + written, c->out_len - written);
+  c->out_len -= written;
+
+  int want_write = c->out_len > 0;
+  if (want_write != c->want_write) {
+    c->want_write = want_write;
+    update_events(c);
+  }
+}
+
+// Picks a random legal move for session `s` and sends it.
+static void play_random_move(Client *c, int i) {
+  ClientSession *s = &c->sessions[i];
+  Move moves[MAX_MOVES];
+  int count = generate_moves(&s->game, moves, MAX_MOVES);
+
+  if (count == 0) {
+    // no way to go on, start over
+    init_game(&s->game);
+    send_request(c, i, "RESET %d\n", s->id);
+    return;
+  }
+
+  char mv[5];
+  s->pending = moves[rand() % count];
+  format_move(s->pending, mv);
+  send_request(c, i, "MOVE %d %s\n", s->id, mv);
+}
+
+static void record_latency(uint64_t sent) {
+  uint64_t latency = now_us() - sent;
+  HISTOGRAM[latency < HISTOGRAM_SIZE ? latency : HISTOGRAM_SIZE - 1]++;
+  if (latency > MAX_LATENCY) {
+    MAX_LATENCY = latency;
+  }
+}
+
+// Handles the answer `line` to the oldest request of `c`.
+static void handle_answer(Client *c, char *line, int running) {
+  if (c->queue_len == 0) {
+    fprintf(stderr, "[ERROR] - Unexpected answer \"%s\"\n", line);
+    ERRORS++;
+    return;
+  }
+
+  int i = c->queue_session[c->queue_head];
+  uint64_t sent = c->queue_sent[c->queue_head];
+  c->queue_head = (c->queue_head + 1) % (c->sessions_count + 1);
+  c->queue_len--;
+
+  ClientSession *s = &c->sessions[i];
+
+  if (strncmp(line, "OK ", 3) != 0) {
+    fprintf(stderr, "[ERROR] - Session %d: %s\n", s->id, line);
+    ERRORS++;
+    init_game(&s->game);
+    if (running) {
+      send_request(c, i, "RESET %d\n", s->id);
+    }
+    return;
+  }
+
+  if (s->id < 0) {
+    // answer to NEW
+    s->id = atoi(line + 3);
+  } else if (strstr(line, "ONGOING") || strstr(line, "WON") || strstr(line, "DRAW")) {
+    record_latency(sent);
+    MOVES_DONE++;
+
+    Piece *p = s->game.board[s->pending.start.x][s->pending.start.y];
+    move_piece(&s->game, p, s->pending.end);
+
+    if (!strstr(line, "ONGOING")) {
+      GAMES_DONE++;
+      init_game(&s->game);
+      if (running) {
+	send_request(c, i, "RESET %d\n", s->id);
+      }
+      return;
+    }
+  }
+
+  if (running) {
+    play_random_move(c, i);
+  }
+}
+
+static void handle_input(Client *c, int running) {
+  for (;;) {
+    ssize_t n = read(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (n <= 0) {
+      fprintf(stderr, "[ERROR] - Lost connection to the server\n");
+      exit(1);
+    }
+    c->in_len += n;
+
+    size_t start = 0;
+    for (size_t i = 0; i < c->in_len; i++) {
+      if (c->in[i] == '\n') {
+	c->in[i] = '\0';
+	if (strncmp(c->in + start, "UPDATE ", 7) != 0) {
+	  handle_answer(c, c->in + start, running);
+	}
+	start = i + 1;
+      }
+    }
+
+    memmove(c->in, c->in + start, c->in_len - start);
+    c->in_len -= start;
+  }
+
+  flush_client(c);
+}
+
+// ----------------------------------------
+
+static void print_percentile(const char *name, double q, uint64_t total) {
+  uint64_t target = (uint64_t) (q * total), seen = 0;
+
+  for (int i = 0; i < HISTOGRAM_SIZE; i++) {
+    seen += HISTOGRAM[i];
+    if (seen > target) {
+      printf("  %-6s %8d us\n", name, i);
+      return;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  int port = SERVER_DEFAULT_PORT;
+  const char *unix_path = NULL;
+  int connections = DEFAULT_CONNECTIONS, sessions = DEFAULT_SESSIONS, seconds = DEFAULT_SECONDS;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "p:u:c:s:t:")) != -1) {
+    switch (opt) {
+    case 'p': port = atoi(optarg); break;
+    case 'u': unix_path = optarg; break;
+    case 'c': connections = atoi(optarg); break;
+    case 's': sessions = atoi(optarg); break;
+    case 't': seconds = atoi(optarg); break;
+    default:
+      fprintf(stderr, "Usage: %s [-p port | -u socket_path] [-c connections] [-s sessions] [-t seconds]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (connections < 1 || sessions < connections || seconds < 1) {
+    fprintf(stderr, "[ERROR] - Need at least one session per connection and one second\n");
+    return 1;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  srand((unsigned) time(NULL));
+
+  HISTOGRAM = calloc(HISTOGRAM_SIZE, sizeof(uint64_t));
+  Client *clients = calloc(connections, sizeof(Client));
+  EPOLL_FD = epoll_create1(0);
+  if (!HISTOGRAM || !clients || EPOLL_FD < 0) {
+    fprintf(stderr, "[ERROR] - Could not set up %d connections\n", connections);
+    return 1;
+  }
+
+  for (int k = 0; k < connections; k++) {
+    Client *c = &clients[k];
+    c->sessions_count = sessions * (k + 1) / connections - sessions * k / connections;
+    c->sessions = calloc(c->sessions_count, sizeof(ClientSession));
+    c->queue_session = malloc((c->sessions_count + 1) * sizeof(int));
+    c->queue_sent = malloc((c->sessions_count + 1) * sizeof(uint64_t));
+    c->fd = connect_server(port, unix_path);
+
+    if (!c->sessions || !c->queue_session || !c->queue_sent || c->fd < 0) {
+      return 1;
+    }
+    fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    epoll_ctl(EPOLL_FD, EPOLL_CTL_ADD, c->fd, &ev);
+
+    for (int i = 0; i < c->sessions_count; i++) {
+      c->sessions[i].id = -1;
+      init_game(&c->sessions[i].game);
+      send_request(c, i, "NEW\n");
+    }
+    flush_client(c);
+  }
+
+  uint64_t start = now_us();
+  uint64_t deadline = start + (uint64_t) seconds * 1000000;
+  int running = 1;
+
+  struct epoll_event events[64];
+
+  for (;;) {
+    uint64_t now = now_us();
+    if (running && now >= deadline) {
+      running = 0;
+    }
+
+    // once stopped, wait for the moves still in flight
+    int in_flight = 0;
+    for (int k = 0; k < connections; k++) {
+      in_flight += clients[k].queue_len;
+    }
+    if (!running && in_flight == 0) {
+      break;
+    }
+
+    int timeout = running ? (int) ((deadline - now) / 1000) + 1 : 1000;
+    int n = epoll_wait(EPOLL_FD, events, 64, timeout);
+    if (n < 0 && errno != EINTR) {
+      perror("[ERROR] - epoll_wait");
+      return 1;
+    }
+    if (n == 0 && !running) {
+      fprintf(stderr, "[ERROR] - %d requests left unanswered\n", in_flight);
+      break;
+    }
+
+    for (int i = 0; i < n; i++) {
+      Client *c = events[i].data.ptr;
+      if (events[i].events & EPOLLOUT) {
+	flush_client(c);
+      }
+      if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+	handle_input(c, running);
+      }
+    }
+  }
+
+  double elapsed = (now_us() - start) / 1e6;
+
+  printf("%d sessions over %d connections, %.1f s\n", sessions, connections, elapsed);
+  printf("  moves  %ld (%.0f moves/s)\n", MOVES_DONE, MOVES_DONE / elapsed);
+  printf("  games  %ld\n", GAMES_DONE);
+  printf("  errors %ld\n", ERRORS);
+
+  if (MOVES_DONE > 0) {
+    printf("latency\n");
+    print_percentile("p50", 0.50, MOVES_DONE);
+    print_percentile("p90", 0.90, MOVES_DONE);
+    print_percentile("p99", 0.99, MOVES_DONE);
+    print_percentile("p99.9", 0.999, MOVES_DONE);
+    printf("  %-6s %8lu us\n", "max", (unsigned long) MAX_LATENCY);
+  }
+
+  for (int k = 0; k < connections; k++) {
+    close(clients[k].fd);
+    free(clients[k].sessions);
+    free(clients[k].queue_session);
+    free(clients[k].queue_sent);
+    free(clients[k].out);
+  }
+  free(clients);
+  free(HISTOGRAM);
+  close(EPOLL_FD);
+
+  return ERRORS > 0;
+}
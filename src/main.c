@@ -72,9 +72,15 @@ int main(void) {
 	} else {
 	  // player has moved a piece
 	  int finished = move_piece(&GAME, GAME.selected_piece, new_pos);
+	  DrawReason draw = finished ? DRAW_NONE : check_draw(&GAME);
 
 	  if (finished) {
 	    printf("Game is over: Player %s won!\n", GAME.selected_player->player_name);
+	  } else if (draw != DRAW_NONE) {
+	    printf("Game is over: draw (%s)!\n", draw_reason_name(draw));
+	  }
+
+	  if (finished || draw != DRAW_NONE) {
 	    printf("Resetting ...\n\n");
 	    destroy_game(&GAME);
 	    init_game(&GAME);
@@ -88,6 +94,7 @@ int main(void) {
   }
 
   destroy_game(&GAME);
+  destroy_piece_textures();
   
   SDL_DestroyRenderer(renderer);
   SDL_DestroyWindow(window);
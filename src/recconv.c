@@ -0,0 +1,114 @@
+/*
+  Converts positions between FEN and the binary record format.
+
+    ./recconv pack   positions.fen positions.bin
+    ./recconv unpack positions.bin
+
+  `pack` expects one FEN per line, `unpack` prints one FEN per line
+  for position files and, for game files, the starting FEN followed
+  by the moves in coordinate notation (e.g. e7e5).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+
+// ----------------------------------------
+
+static int pack(const char *in_path, const char *out_path) {
+  FILE *in = fopen(in_path, "r");
+  if (!in) {
+    fprintf(stderr, "[ERROR] - Could not open %s\n", in_path);
+    return 1;
+  }
+
+  RecordWriter w;
+  if (!record_writer_open(&w, out_path, RECORD_KIND_POSITIONS)) {
+    fclose(in);
+    return 1;
+  }
+
+  char line[256];
+  int line_no = 0, errors = 0;
+  while (fgets(line, sizeof(line), in)) {
+    line_no++;
+    if (line[0] == '\n' || line[0] == '#') {
+      continue;
+    }
+
+    PosRecord r;
+    if (!fen_to_record(line, &r)) {
+      fprintf(stderr, "[ERROR] - %s:%d: invalid FEN\n", in_path, line_no);
+      errors++;
+      continue;
+    }
+    if (!record_write_position(&w, &r)) {
+      fprintf(stderr, "[ERROR] - Could not write %s\n", out_path);
+      fclose(in);
+      record_writer_close(&w);
+      return 1;
+    }
+  }
+
+  fclose(in);
+  if (!record_writer_close(&w)) {
+    fprintf(stderr, "[ERROR] - Could not write %s\n", out_path);
+    return 1;
+  }
+
+  printf("Packed %lu positions (%d skipped)\n", (unsigned long) w.count, errors);
+  return 0;
+}
+
+static int unpack(const char *in_path) {
+  RecordReader r;
+  if (!record_reader_open(&r, in_path)) {
+    return 1;
+  }
+
+  char fen[FEN_MAX_LEN];
+
+  if (r.kind == RECORD_KIND_POSITIONS) {
+    const PosRecord *rec;
+    while ((rec = record_next_position(&r))) {
+      record_to_fen(rec, fen, sizeof(fen));
+      printf("%s\n", fen);
+    }
+  } else {
+    GameView g;
+    while (record_next_game(&r, &g)) {
+      record_to_fen(&g.header->start, fen, sizeof(fen));
+      printf("%s\n", fen);
+
+      for (int i = 0; i < g.header->move_count; i++) {
+	char mv[5];
+	format_move((Move) {packed_move_start(g.moves[i]), packed_move_end(g.moves[i])}, mv);
+	printf("%s%s", mv, i + 1 < g.header->move_count ? " " : "\n");
+      }
+    }
+  }
+
+  if (r.skipped) {
+    fprintf(stderr, "[ERROR] - %llu invalid records were skipped\n", (unsigned long long) r.skipped);
+  }
+
+  record_reader_close(&r);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 4 && !strcmp(argv[1], "pack")) {
+    return pack(argv[2], argv[3]);
+  }
+
+  if (argc == 3 && !strcmp(argv[1], "unpack")) {
+    return unpack(argv[2]);
+  }
+
+  fprintf(stderr, "Usage: %s pack <in.fen> <out.bin>\n", argv[0]);
+  fprintf(stderr, "       %s unpack <in.bin>\n", argv[0]);
+  return 1;
+}
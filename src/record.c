@@ -0,0 +1,453 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+
+_Static_assert(sizeof(RecordFileHeader) == 16, "RecordFileHeader must be 16 bytes");
+_Static_assert(sizeof(PosRecord) == 32, "PosRecord must be 32 bytes");
+_Static_assert(sizeof(GameRecordHeader) == 40, "GameRecordHeader must be 40 bytes");
+
+#define ALIGN8(n) (((n) + 7) & ~((size_t) 7))
+
+// ----------------------------------------
+// FUNCTIONS
+
+static const char PIECE_CHARS[] = "kqrbnpKQRBNP";
+
+static PieceType char2type(char c) {
+  const char *s = strchr(PIECE_CHARS, c);
+  return (c && s) ? (PieceType) (s - PIECE_CHARS) : EMPTY;
+}
+
+PackedMove pack_move(Pos start_pos, Pos end_pos) {
+  int start = start_pos.y * BOARD_WIDTH + start_pos.x;
+  int end = end_pos.y * BOARD_WIDTH + end_pos.x;
+  return (PackedMove) (start | (end << 6));
+}
+
+Pos packed_move_start(PackedMove m) {
+  int s = m & 0x3F;
+  return (Pos) {s % BOARD_WIDTH, s / BOARD_WIDTH};
+}
+
+Pos packed_move_end(PackedMove m) {
+  int s = (m >> 6) & 0x3F;
+  return (Pos) {s % BOARD_WIDTH, s / BOARD_WIDTH};
+}
+
+// Returns the type of the i-th piece of the nibble array.
+static PieceType record_nibble(const PosRecord *r, int i) {
+  return (PieceType) ((r->pieces[i / 2] >> ((i % 2) * 4)) & 0xF);
+}
+
+// Returns the piece standing on `square`, or EMPTY. The index of the
+// piece inside the nibble array is the number of occupied squares
+// that come before `square`.
+PieceType record_piece_at(const PosRecord *r, int square) {
+  uint64_t bit = (uint64_t) 1 << square;
+  if (!(r->occupancy & bit)) {
+    return EMPTY;
+  }
+
+  return record_nibble(r, __builtin_popcountll(r->occupancy & (bit - 1)));
+}
+
+// Checks that `r` can be decoded safely: at most MAX_PIECES pieces,
+// all of a valid type, and a valid side to move. Records built in
+// memory always are, the ones read from a file may not be.
+int record_is_valid(const PosRecord *r) {
+  int count = __builtin_popcountll(r->occupancy);
+  if (count > MAX_PIECES || r->w_to_move > 1) {
+    return 0;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (record_nibble(r, i) >= EMPTY) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// Parses `fen` into `r`. Castling and en-passant fields are accepted
+// but ignored, since the rules core does not support them. The clocks
+// are optional.
+//
+// Returns 1 on success and 0 if the string is malformed.
+int fen_to_record(const char *fen, PosRecord *r) {
+  memset(r, 0, sizeof(*r));
+
+  int x = 0, y = 0, count = 0;
+  const char *c = fen;
+
+  for (; *c && *c != ' '; c++) {
+    if (*c == '/') {
+      if (x != BOARD_WIDTH || ++y >= BOARD_HEIGHT) {
+	return 0;
+      }
+      x = 0;
+    } else if (*c >= '1' && *c <= '8') {
+      x += *c - '0';
+      if (x > BOARD_WIDTH) {
+	return 0;
+      }
+    } else {
+      PieceType t = char2type(*c);
+      if (t == EMPTY || x >= BOARD_WIDTH || count >= 32) {
+	return 0;
+      }
+
+      r->occupancy |= (uint64_t) 1 << (y * BOARD_WIDTH + x);
+      r->pieces[count / 2] |= (uint8_t) (t << ((count % 2) * 4));
+      count++;
+      x++;
+    }
+  }
+
+  if (x != BOARD_WIDTH || y != BOARD_HEIGHT - 1 || *c != ' ') {
+    return 0;
+  }
+
+  // side to move
+  c++;
+  if (*c != 'w' && *c != 'b') {
+    return 0;
+  }
+  r->w_to_move = *c == 'w';
+  c++;
+
+  // castling and en-passant, then the two clocks
+  long clocks[2] = {0, 1};
+  for (int field = 0; field < 4 && *c == ' '; field++) {
+    while (*c == ' ') { c++; }
+    if (!*c) { break; }
+
+    if (field < 2) {
+      while (*c && *c != ' ') { c++; }
+      continue;
+    }
+
+    char *end;
+    long v = strtol(c, &end, 10);
+    if (end == c || v < 0 || v > UINT16_MAX) {
+      return 0;
+    }
+    clocks[field - 2] = v;
+    c = end;
+  }
+
+  while (*c == ' ' || *c == '\n' || *c == '\r') { c++; }
+  if (*c) {
+    return 0;
+  }
+
+  r->halfmove_clock = (uint16_t) clocks[0];
+  r->fullmove_number = (uint16_t) clocks[1];
+
+  return 1;
+}
+
+void record_to_fen(const PosRecord *r, char *fen, size_t size) {
+  char buf[FEN_MAX_LEN];
+  int n = 0;
+
+  for (int y = 0; y < BOARD_HEIGHT; y++) {
+    int empty = 0;
+
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+      PieceType t = record_piece_at(r, y * BOARD_WIDTH + x);
+      if (t == EMPTY) {
+	empty++;
+	continue;
+      }
+
+      if (empty) {
+	buf[n++] = (char) ('0' + empty);
+	empty = 0;
+      }
+      buf[n++] = PIECE_CHARS[t];
+    }
+
+    if (empty) {
+      buf[n++] = (char) ('0' + empty);
+    }
+    if (y != BOARD_HEIGHT - 1) {
+      buf[n++] = '/';
+    }
+  }
+
+  snprintf(buf + n, sizeof(buf) - n, " %c - - %u %u",
+	   r->w_to_move ? 'w' : 'b', r->halfmove_clock, r->fullmove_number);
+  snprintf(fen, size, "%s", buf);
+}
+
+// ----------
+
+void record_from_game(PosRecord *r, const Game *game) {
+  memset(r, 0, sizeof(*r));
+
+  int count = 0;
+  for (int y = 0; y < BOARD_HEIGHT; y++) {
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+      const Piece *p = game->board[x][y];
+      if (!p) {
+	continue;
+      }
+
+      assert(count < 32 && "a position can hold at most 32 pieces!");
+      r->occupancy |= (uint64_t) 1 << (y * BOARD_WIDTH + x);
+      r->pieces[count / 2] |= (uint8_t) (p->type << ((count % 2) * 4));
+      count++;
+    }
+  }
+
+  // black moves first, so a move is over once white has played.
+  int fullmove = 1 + (game->start_ply + game->ply) / 2;
+
+  r->w_to_move = IS_PLAYER_WHITE(game);
+  r->halfmove_clock = (uint16_t) game->halfmove_clock;
+  r->fullmove_number = (uint16_t) (fullmove < UINT16_MAX ? fullmove : UINT16_MAX);
+}
+
+// Replaces the state of `game` with the position stored in `r`.
+void record_to_game(const PosRecord *r, Game *game) {
+  memset(game, 0, sizeof(*game));
+
+  for (int y = 0; y < BOARD_HEIGHT; y++) {
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+      PieceType t = record_piece_at(r, y * BOARD_WIDTH + x);
+      game->board[x][y] = t != EMPTY ? init_piece(game, t, (Pos){x, y}) : NULL;
+    }
+  }
+
+  game->b_player.player_name = B_PLAYER_NAME;
+  game->w_player.player_name = W_PLAYER_NAME;
+  game->selected_player = r->w_to_move ? &game->w_player : &game->b_player;
+
+  int fullmove = r->fullmove_number ? r->fullmove_number : 1;
+  game->start_ply = (fullmove - 1) * 2 + r->w_to_move;
+
+  reset_history(game, r->halfmove_clock);
+}
+
+// Lighter version of record_to_game() meant for code that goes
+// through many positions: only board, pieces and selected player are
+// set. Key and history are left as they are, call reset_history() if
+// they are needed.
+//
+// NOTE: `r` must be valid (see record_is_valid()), pieces beyond
+// MAX_PIECES are dropped rather than written past the pool.
+void record_load_board(const PosRecord *r, Game *game) {
+  memset(game->board, 0, sizeof(game->board));
+
+  uint64_t occupancy = r->occupancy;
+  int i = 0;
+  for (; occupancy && i < MAX_PIECES; i++, occupancy &= occupancy - 1) {
+    int square = __builtin_ctzll(occupancy);
+    Pos pos = {square % BOARD_WIDTH, square / BOARD_WIDTH};
+
+    game->pieces[i].type = record_nibble(r, i);
+    game->pieces[i].pos = pos;
+    game->board[pos.x][pos.y] = &game->pieces[i];
+  }
+
+  game->pieces_count = i;
+  game->selected_player = r->w_to_move ? &game->w_player : &game->b_player;
+}
+
+// ----------------------------------------
+// WRITER
+
+int record_writer_open(RecordWriter *w, const char *path, RecordKind kind) {
+  w->fp = fopen(path, "wb");
+  if (!w->fp) {
+    fprintf(stderr, "[ERROR] - Could not open %s for writing\n", path);
+    return 0;
+  }
+
+  w->kind = kind;
+  w->count = 0;
+
+  // the header is written again with the final count on close
+  RecordFileHeader h = {0};
+  return fwrite(&h, sizeof(h), 1, w->fp) == 1;
+}
+
+int record_write_position(RecordWriter *w, const PosRecord *r) {
+  assert(w->kind == RECORD_KIND_POSITIONS && "writer does not hold positions!");
+
+  if (fwrite(r, sizeof(*r), 1, w->fp) != 1) {
+    return 0;
+  }
+
+  w->count++;
+  return 1;
+}
+
+int record_write_game(RecordWriter *w, const PosRecord *start,
+		      const PackedMove *moves, uint16_t move_count, RecordResult result) {
+  assert(w->kind == RECORD_KIND_GAMES && "writer does not hold games!");
+  static const uint8_t padding[8] = {0};
+
+  GameRecordHeader h = {0};
+  h.start = *start;
+  h.move_count = move_count;
+  h.result = (uint8_t) result;
+
+  size_t moves_size = move_count * sizeof(PackedMove);
+  if (fwrite(&h, sizeof(h), 1, w->fp) != 1 ||
+      fwrite(moves, 1, moves_size, w->fp) != moves_size ||
+      fwrite(padding, 1, ALIGN8(moves_size) - moves_size, w->fp) != ALIGN8(moves_size) - moves_size) {
+    return 0;
+  }
+
+  w->count++;
+  return 1;
+}
+
+int record_writer_close(RecordWriter *w) {
+  RecordFileHeader h = {0};
+  memcpy(h.magic, RECORD_MAGIC, sizeof(h.magic));
+  h.version = RECORD_VERSION;
+  h.kind = (uint16_t) w->kind;
+  h.count = w->count;
+
+  int ok = fseek(w->fp, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, w->fp) == 1;
+  ok = (fclose(w->fp) == 0) && ok;
+  w->fp = NULL;
+
+  return ok;
+}
+
+// ----------------------------------------
+// READER
+
+// Maps the whole file in memory. Records are never copied nor
+// decoded up-front: record_next_position() and record_next_game()
+// simply return pointers inside the mapping.
+int record_reader_open(RecordReader *r, const char *path) {
+  memset(r, 0, sizeof(*r));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "[ERROR] - Could not open %s\n", path);
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(RecordFileHeader)) {
+    fprintf(stderr, "[ERROR] - %s is not a record file\n", path);
+    close(fd);
+    return 0;
+  }
+
+  void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    fprintf(stderr, "[ERROR] - Could not map %s\n", path);
+    return 0;
+  }
+  madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+  const RecordFileHeader *h = base;
+  if (memcmp(h->magic, RECORD_MAGIC, sizeof(h->magic)) || h->version != RECORD_VERSION ||
+      h->kind > RECORD_KIND_GAMES) {
+    fprintf(stderr, "[ERROR] - %s has an invalid header\n", path);
+    munmap(base, st.st_size);
+    return 0;
+  }
+
+  r->base = base;
+  r->size = st.st_size;
+  r->offset = sizeof(*h);
+  r->kind = (RecordKind) h->kind;
+  r->count = h->count;
+
+  return 1;
+}
+
+// Returns the next valid position, or NULL once the file is over.
+// Invalid records are skipped and counted in `r->skipped`.
+const PosRecord *record_next_position(RecordReader *r) {
+  assert(r->kind == RECORD_KIND_POSITIONS && "reader does not hold positions!");
+
+  while (r->offset + sizeof(PosRecord) <= r->size) {
+    const PosRecord *rec = (const PosRecord *) (r->base + r->offset);
+    r->offset += sizeof(PosRecord);
+
+    if (record_is_valid(rec)) {
+      return rec;
+    }
+    r->skipped++;
+  }
+
+  return NULL;
+}
+
+// Returns all the positions of the file as a single array, which
+// points directly inside the mapping. Since the array can not skip
+// records, NULL is returned if any of them is invalid.
+const PosRecord *record_positions(const RecordReader *r, size_t *count) {
+  assert(r->kind == RECORD_KIND_POSITIONS && "reader does not hold positions!");
+
+  const PosRecord *positions = (const PosRecord *) (r->base + sizeof(RecordFileHeader));
+  size_t n = (r->size - sizeof(RecordFileHeader)) / sizeof(PosRecord);
+
+  for (size_t i = 0; i < n; i++) {
+    if (!record_is_valid(&positions[i])) {
+      fprintf(stderr, "[ERROR] - Position %zu of the record file is invalid\n", i);
+      *count = 0;
+      return NULL;
+    }
+  }
+
+  *count = n;
+  return positions;
+}
+
+// Fills `view` with the next game whose starting position is valid,
+// the other ones are skipped and counted in `r->skipped`. Returns 0
+// once the file is over or if the last game is truncated.
+int record_next_game(RecordReader *r, GameView *view) {
+  assert(r->kind == RECORD_KIND_GAMES && "reader does not hold games!");
+
+  while (r->offset + sizeof(GameRecordHeader) <= r->size) {
+    const GameRecordHeader *h = (const GameRecordHeader *) (r->base + r->offset);
+    size_t moves_size = ALIGN8(h->move_count * sizeof(PackedMove));
+    if (r->offset + sizeof(*h) + moves_size > r->size) {
+      return 0;
+    }
+
+    size_t offset = r->offset;
+    r->offset += sizeof(*h) + moves_size;
+
+    if (!record_is_valid(&h->start)) {
+      r->skipped++;
+      continue;
+    }
+
+    view->header = h;
+    view->moves = (const PackedMove *) (r->base + offset + sizeof(*h));
+    return 1;
+  }
+
+  return 0;
+}
+
+void record_reader_close(RecordReader *r) {
+  if (r->base) {
+    munmap((void *) r->base, r->size);
+  }
+  memset(r, 0, sizeof(*r));
+}
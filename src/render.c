@@ -8,6 +8,13 @@
 #include "./include/game.h"
 #include "./include/render.h"
 
+// ----------------------------------------
+// GLOBAL VARIABLES
+
+// Textures are shared by all pieces of the same type. Each one is
+// created the first time a piece of that type is rendered.
+SDL_Texture *PIECE_TEXTURES[EMPTY] = {0};
+
 // ----------------------------------------
 
 void sdl2_c(int code) {
@@ -84,10 +91,11 @@ void render_board(SDL_Renderer *renderer) {
 }
 
 void render_piece(SDL_Renderer *renderer, Piece *p, int selected) {
-  // is this the first time we render this piece?
-  if (!p->texture) {
-    p->image = img_p(IMG_Load(p->image_path));
-    p->texture = SDL_CreateTextureFromSurface(renderer, p->image);
+  // is this the first time we render this type of piece?
+  if (!PIECE_TEXTURES[p->type]) {
+    SDL_Surface *image = img_p(IMG_Load(p->image_path));
+    PIECE_TEXTURES[p->type] = SDL_CreateTextureFromSurface(renderer, image);
+    SDL_FreeSurface(image);
   }
   
   SDL_Rect chess_pos = {
@@ -97,7 +105,7 @@ void render_piece(SDL_Renderer *renderer, Piece *p, int selected) {
     (int) floorf(CELL_HEIGHT),
   };
 
-  SDL_RenderCopy(renderer, p->texture, NULL, &chess_pos);
+  SDL_RenderCopy(renderer, PIECE_TEXTURES[p->type], NULL, &chess_pos);
   
   if (selected) {
     render_pos_highlight(renderer, p->pos, HEX_COLOR(HIGHLIGHT_COLOR_1));
@@ -179,3 +187,12 @@ void render_valid_moves(SDL_Renderer *renderer, const Game *game) {
     render_pos_highlight(renderer, p, HEX_COLOR(HIGHLIGHT_COLOR_2));
   }
 }
+
+// Textures belong to the renderer that created them, so this must be
+// called before destroying it.
+void destroy_piece_textures(void) {
+  for (int t = 0; t < EMPTY; t++) {
+    SDL_DestroyTexture(PIECE_TEXTURES[t]);
+    PIECE_TEXTURES[t] = NULL;
+  }
+}
@@ -0,0 +1,159 @@
+/*
+  Headless self-play runner: the engine plays against itself starting
+  from DEFAULT_BOARD.
+
+    ./selfplay [-n games] [-d depth] [-m max_plies] [-s seed]
+               [-b book.bin [-w]] [-t tables_dir]
+               [-o games.bin]
+
+  -b enables the Polyglot opening book, -w picks book moves at
+  random according to their weights instead of always playing the
+  best one. -t enables the endgame tables found in the given
+  directories (separated by ':'). -o stores the played games in the
+  binary record format.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+#include "./include/book.h"
+#include "./include/tb.h"
+#include "./include/engine.h"
+#include "./include/session.h"
+
+#define DEFAULT_MAX_PLIES 200
+
+// ----------------------------------------
+
+// Plays a whole game within `s`, which is reset first.
+static RecordResult play_game(Engine *e, Session *s, int max_plies, PosRecord *start) {
+  session_reset(s);
+  record_from_game(start, s->game);
+
+  RecordResult result = RECORD_RESULT_UNKNOWN;
+
+  for (int ply = 0; ply < max_plies; ply++) {
+    Move m;
+    if (!engine_pick_move(e, s->game, &m)) {
+      break;
+    }
+
+    char mv[5];
+    format_move(m, mv);
+    printf("%s ", mv);
+
+    if (session_play(s, m) == 1) {
+      result = IS_PLAYER_WHITE(s->game) ? RECORD_RESULT_W_WON : RECORD_RESULT_B_WON;
+      break;
+    }
+
+    DrawReason draw = check_draw(s->game);
+    if (draw != DRAW_NONE) {
+      printf("(%s) ", draw_reason_name(draw));
+      result = RECORD_RESULT_DRAW;
+      break;
+    }
+  }
+
+  printf("\n");
+  return result;
+}
+
+int main(int argc, char **argv) {
+  int games = 1, max_plies = DEFAULT_MAX_PLIES;
+  unsigned seed = 0;
+  const char *book_path = NULL, *out_path = NULL, *tb_path = NULL;
+
+  Engine engine = {.depth = DEFAULT_SEARCH_DEPTH, .book_select = BOOK_SELECT_BEST};
+  Book book;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:d:m:s:b:wt:o:")) != -1) {
+    switch (opt) {
+    case 'n': games = atoi(optarg); break;
+    case 'd': engine.depth = atoi(optarg); break;
+    case 'm': max_plies = atoi(optarg); break;
+    case 's': seed = (unsigned) strtoul(optarg, NULL, 10); break;
+    case 'b': book_path = optarg; break;
+    case 'w': engine.book_select = BOOK_SELECT_WEIGHTED; break;
+    case 't': tb_path = optarg; break;
+    case 'o': out_path = optarg; break;
+    default:
+      fprintf(stderr, "Usage: %s [-n games] [-d depth] [-m max_plies] [-s seed] "
+	      "[-b book.bin [-w]] [-t tables_dir] [-o games.bin]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (engine.depth < 1 || max_plies < 1 || max_plies > SESSION_HISTORY_CAPACITY) {
+    fprintf(stderr, "[ERROR] - depth must be positive and max plies within 1 and %d\n",
+	    SESSION_HISTORY_CAPACITY);
+    return 1;
+  }
+
+  srand(seed);
+
+  if (book_path) {
+    if (!book_open(&book, book_path)) {
+      return 1;
+    }
+    engine.book = &book;
+  }
+
+  if (tb_path) {
+    tb_init(tb_path);
+  }
+
+  RecordWriter w;
+  if (out_path && !record_writer_open(&w, out_path, RECORD_KIND_GAMES)) {
+    return 1;
+  }
+
+  Session session;
+  if (!session_init(&session)) {
+    return 1;
+  }
+
+  int results[RECORD_RESULT_DRAW + 1] = {0};
+
+  for (int i = 0; i < games; i++) {
+    PosRecord start;
+
+    printf("Game %d: ", i + 1);
+    RecordResult result = play_game(&engine, &session, max_plies, &start);
+    results[result]++;
+
+    if (out_path) {
+      record_write_game(&w, &start, session.history, (uint16_t) session.history_count, result);
+    }
+  }
+
+  printf("Results: %s %d, %s %d, draws %d, unfinished %d\n",
+	 W_PLAYER_NAME, results[RECORD_RESULT_W_WON],
+	 B_PLAYER_NAME, results[RECORD_RESULT_B_WON],
+	 results[RECORD_RESULT_DRAW],
+	 results[RECORD_RESULT_UNKNOWN]);
+
+  if (tb_path) {
+    printf("Tables: %d mapped, %ld/%ld search hits, %ld/%ld root hits\n",
+	   TB_STATS.tables_mapped, TB_STATS.wdl_hits, TB_STATS.wdl_probes,
+	   TB_STATS.root_hits, TB_STATS.root_probes);
+    tb_free();
+  }
+
+  session_destroy(&session);
+  if (out_path && !record_writer_close(&w)) {
+    fprintf(stderr, "[ERROR] - Could not write %s\n", out_path);
+  }
+  if (engine.book) {
+    book_close(&book);
+  }
+
+  return 0;
+}
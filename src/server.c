@@ -0,0 +1,670 @@
+/*
+  Headless server hosting many independent games at once.
+
+    ./server [-p port | -u socket_path] [-n max_sessions]
+
+  Clients connect over TCP (on 127.0.0.1) or over a Unix socket and
+  speak the line based protocol described in include/server.h. Every
+  connection is served by a single epoll event loop.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "./include/game.h"
+#include "./include/record.h"
+#include "./include/session.h"
+#include "./include/server.h"
+
+#define MAX_EVENTS 256
+
+// ----------------------------------------
+// GLOBAL VARIABLES
+
+static volatile sig_atomic_t QUIT = 0;
+
+static int EPOLL_FD = -1;
+
+static ServerSession *SESSIONS = NULL;
+static int SESSIONS_COUNT = 0;
+
+// ids of the sessions not in use, used as a stack.
+static int *FREE_SESSIONS = NULL;
+static int FREE_SESSIONS_COUNT = 0;
+
+// connections indexed by file descriptor.
+static Conn **CONNS = NULL;
+static int CONNS_CAPACITY = 0;
+static uint64_t NEXT_CONN_ID = 1;
+
+static long MOVES_PLAYED = 0;
+
+// ----------------------------------------
+// CONNECTIONS
+
+static void on_signal(int sig) {
+  (void) sig;
+  QUIT = 1;
+}
+
+static int set_nonblocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static Conn *lookup_conn(ConnRef ref) {
+  if (ref.fd < 0 || ref.fd >= CONNS_CAPACITY) {
+    return NULL;
+  }
+
+  Conn *c = CONNS[ref.fd];
+  return (c && c->id == ref.id) ? c : NULL;
+}
+
+static void update_events(Conn *c) {
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN | (c->want_write ? EPOLLOUT : 0);
+  ev.data.fd = c->fd;
+  epoll_ctl(EPOLL_FD, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void release_session(int id);
+
+static void close_conn(Conn *c) {
+  // sessions die together with the connection that created them
+  for (int i = 0; i < SESSIONS_COUNT && c->sessions_count > 0; i++) {
+    ServerSession *s = &SESSIONS[i];
+    if (s->in_use && s->owner.fd == c->fd && s->owner.id == c->id) {
+      release_session(i);
+      c->sessions_count--;
+    }
+  }
+
+  epoll_ctl(EPOLL_FD, EPOLL_CTL_DEL, c->fd, NULL);
+  close(c->fd);
+
+  CONNS[c->fd] = NULL;
+  free(c->out);
+  free(c);
+}
+
+// Writes as much pending output as the socket accepts.
+//
+// Returns 0 if the connection has been closed.
+static int flush_conn(Conn *c) {
+  size_t written = 0;
+
+  while (written < c->out_len) {
+    ssize_t n = write(c->fd, c->out + written, c->out_len - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (n <= 0) {
+      close_conn(c);
+      return 0;
+    }
+    written += n;
+  }
+
+  memmove(c->out, c->out + written, c->out_len - written);
+  c->out_len -= written;
+
+  int want_write = c->out_len > 0;
+  if (want_write != c->want_write) {
+    c->want_write = want_write;
+    update_events(c);
+  }
+
+  return 1;
+}
+
+// Queues `line` (which must end with '\n') on the output of `c`.
+//
+// Returns 0 if the connection had to be dropped.
+static int send_line(Conn *c, const char *line, size_t len) {
+  if (c->out_len + len > c->out_capacity) {
+    size_t capacity = c->out_capacity ? c->out_capacity : 4096;
+    while (capacity < c->out_len + len) {
+      capacity *= 2;
+    }
+
+    if (capacity > SERVER_MAX_OUTPUT) {
+      fprintf(stderr, "[ERROR] - Connection %d is not reading, dropping it\n", c->fd);
+      close_conn(c);
+      return 0;
+    }
+
+    char *out = realloc(c->out, capacity);
+    if (!out) {
+      close_conn(c);
+      return 0;
+    }
+    c->out = out;
+    c->out_capacity = capacity;
+  }
+
+  memcpy(c->out + c->out_len, line, len);
+  c->out_len += len;
+  return 1;
+}
+
+static int reply(Conn *c, const char *fmt, ...) {
+  char line[SERVER_MAX_LINE * 8];
+
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(line, sizeof(line) - 1, fmt, args);
+  va_end(args);
+
+  if (len < 0 || (size_t) len >= sizeof(line) - 1) {
+    len = (int) sizeof(line) - 2;
+  }
+  line[len++] = '\n';
+
+  return send_line(c, line, len);
+}
+
+// ----------------------------------------
+// SESSIONS
+
+static void release_session(int id) {
+  SESSIONS[id].in_use = 0;
+  SESSIONS[id].watchers_count = 0;
+  FREE_SESSIONS[FREE_SESSIONS_COUNT++] = id;
+}
+
+// Sessions are allocated the first time they are used, and kept for
+// later games once released.
+static int acquire_session(Conn *c) {
+  if (FREE_SESSIONS_COUNT == 0) {
+    return -1;
+  }
+
+  int id = FREE_SESSIONS[FREE_SESSIONS_COUNT - 1];
+  ServerSession *s = &SESSIONS[id];
+
+  if (!s->initialized) {
+    if (!session_init(&s->session)) {
+      return -1;
+    }
+    s->initialized = 1;
+  } else {
+    session_reset(&s->session);
+  }
+
+  FREE_SESSIONS_COUNT--;
+  s->in_use = 1;
+  s->finished = 0;
+  s->owner = (ConnRef) {c->fd, c->id};
+  s->watchers_count = 0;
+  c->sessions_count++;
+
+  return id;
+}
+
+static ServerSession *lookup_session(const char *arg, int *id) {
+  char *end;
+  long v = arg ? strtol(arg, &end, 10) : -1;
+
+  if (!arg || end == arg || *end || v < 0 || v >= SESSIONS_COUNT || !SESSIONS[v].in_use) {
+    return NULL;
+  }
+
+  *id = (int) v;
+  return &SESSIONS[v];
+}
+
+// Writes the status of `game` after a move into `status`, which must
+// hold SERVER_MAX_LINE chars.
+//
+// Returns 1 if the game is over.
+static int game_status(const Game *game, int finished, char *status) {
+  if (finished) {
+    snprintf(status, SERVER_MAX_LINE, "WON %s", game->selected_player->player_name);
+    return 1;
+  }
+
+  DrawReason draw = check_draw(game);
+  if (draw != DRAW_NONE) {
+    snprintf(status, SERVER_MAX_LINE, "DRAW %s", draw_reason_name(draw));
+    return 1;
+  }
+
+  snprintf(status, SERVER_MAX_LINE, "ONGOING");
+  return 0;
+}
+
+static void game_fen(const Game *game, char *fen) {
+  PosRecord r;
+  record_from_game(&r, game);
+  record_to_fen(&r, fen, FEN_MAX_LEN);
+}
+
+// Returns the index of `c` among the watchers of `s`, or -1.
+static int find_watcher(const ServerSession *s, const Conn *c) {
+  for (int i = 0; i < s->watchers_count; i++) {
+    if (s->watchers[i].fd == c->fd && s->watchers[i].id == c->id) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Sends `line` to everyone watching `s`, except `skip`.
+static void push_update(ServerSession *s, Conn *skip, const char *line, size_t len) {
+  for (int i = 0; i < s->watchers_count; i++) {
+    Conn *w = lookup_conn(s->watchers[i]);
+
+    if (!w) {
+      // the watcher went away, forget about it
+      s->watchers[i--] = s->watchers[--s->watchers_count];
+      continue;
+    }
+
+    if (w != skip && send_line(w, line, len)) {
+      flush_conn(w);
+    }
+  }
+}
+
+// ----------------------------------------
+// REQUESTS
+
+// Handles a single request line.
+//
+// Returns 0 if the connection has been closed.
+static int handle_request(Conn *c, char *line) {
+  char *save;
+  char *cmd = strtok_r(line, " \t\r", &save);
+  char *arg = strtok_r(NULL, " \t\r", &save);
+  char *extra = strtok_r(NULL, " \t\r", &save);
+
+  if (!cmd) {
+    return 1;
+  }
+
+  if (!strcmp(cmd, "NEW")) {
+    int id = acquire_session(c);
+    return id < 0 ? reply(c, "ERR - no sessions left") : reply(c, "OK %d", id);
+  }
+
+  int id;
+  ServerSession *s = lookup_session(arg, &id);
+  if (!s) {
+    return reply(c, "ERR %s unknown session", arg ? arg : "-");
+  }
+
+  Game *game = s->session.game;
+  int owner = s->owner.fd == c->fd && s->owner.id == c->id;
+  char fen[FEN_MAX_LEN];
+
+  if (!strcmp(cmd, "MOVE")) {
+    Move m;
+    if (!owner) {
+      return reply(c, "ERR %d not your session", id);
+    }
+    if (!extra || !parse_move(extra, &m)) {
+      return reply(c, "ERR %d malformed move", id);
+    }
+    if (s->finished) {
+      return reply(c, "ERR %d game is over", id);
+    }
+
+    int finished = session_play(&s->session, m);
+    if (finished == SESSION_HISTORY_FULL) {
+      return reply(c, "ERR %d history is full", id);
+    }
+    if (finished < 0) {
+      return reply(c, "ERR %d illegal move", id);
+    }
+    MOVES_PLAYED++;
+
+    char mv[5], status[SERVER_MAX_LINE];
+    format_move(m, mv);
+    s->finished = game_status(game, finished, status);
+
+    char update[SERVER_MAX_LINE * 2];
+    int len = snprintf(update, sizeof(update), "UPDATE %d %s %s\n", id, mv, status);
+    push_update(s, c, update, len);
+
+    return reply(c, "OK %d %s %s", id, mv, status);
+  }
+
+  if (!strcmp(cmd, "MOVES")) {
+    char line[MAX_MOVES * 5 + 32];
+    int len = snprintf(line, sizeof(line), "OK %d", id);
+
+    session_update_moves(&s->session);
+    for (int i = 0; i < s->session.moves_count; i++) {
+      line[len++] = ' ';
+      format_move(s->session.moves[i], line + len);
+      len += 4;
+    }
+    line[len++] = '\n';
+
+    return send_line(c, line, len);
+  }
+
+  if (!strcmp(cmd, "FEN")) {
+    game_fen(game, fen);
+    return reply(c, "OK %d %s", id, fen);
+  }
+
+  if (!strcmp(cmd, "WATCH")) {
+    // watching twice is the same as watching once
+    if (find_watcher(s, c) < 0) {
+      if (s->watchers_count >= SERVER_MAX_WATCHERS) {
+	return reply(c, "ERR %d too many watchers", id);
+      }
+      s->watchers[s->watchers_count++] = (ConnRef) {c->fd, c->id};
+    }
+
+    game_fen(game, fen);
+    return reply(c, "OK %d %s", id, fen);
+  }
+
+  if (!strcmp(cmd, "UNWATCH")) {
+    int i = find_watcher(s, c);
+    if (i < 0) {
+      return reply(c, "ERR %d not watching", id);
+    }
+    s->watchers[i] = s->watchers[--s->watchers_count];
+    return reply(c, "OK %d", id);
+  }
+
+  if (!strcmp(cmd, "RESET") || !strcmp(cmd, "CLOSE")) {
+    if (!owner) {
+      return reply(c, "ERR %d not your session", id);
+    }
+
+    if (!strcmp(cmd, "RESET")) {
+      session_reset(&s->session);
+      s->finished = 0;
+
+      char update[SERVER_MAX_LINE * 2];
+      game_fen(s->session.game, fen);
+      int len = snprintf(update, sizeof(update), "RESET %d %s\n", id, fen);
+      push_update(s, c, update, len);
+    } else {
+      release_session(id);
+      c->sessions_count--;
+    }
+    return reply(c, "OK %d", id);
+  }
+
+  return reply(c, "ERR %d unknown command", id);
+}
+
+// Reads everything available on `c` and handles every complete line.
+static void handle_input(Conn *c) {
+  int fd = c->fd;
+  uint64_t conn_id = c->id;
+
+  for (;;) {
+    ssize_t n = read(fd, c->in + c->in_len, sizeof(c->in) - c->in_len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (n <= 0) {
+      close_conn(c);
+      return;
+    }
+    c->in_len += n;
+
+    size_t start = 0;
+    for (size_t i = 0; i < c->in_len; i++) {
+      if (c->in[i] != '\n') {
+	continue;
+      }
+
+      c->in[i] = '\0';
+      if (!handle_request(c, c->in + start)) {
+	return;
+      }
+      start = i + 1;
+    }
+
+    memmove(c->in, c->in + start, c->in_len - start);
+    c->in_len -= start;
+
+    if (c->in_len == sizeof(c->in)) {
+      fprintf(stderr, "[ERROR] - Connection %d sent a line too long\n", fd);
+      close_conn(c);
+      return;
+    }
+  }
+
+  // handle_request() may have closed the connection while pushing
+  if (lookup_conn((ConnRef) {fd, conn_id})) {
+    flush_conn(c);
+  }
+}
+
+static void accept_conns(int listen_fd) {
+  for (;;) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+	perror("[ERROR] - accept");
+      }
+      return;
+    }
+
+    if (fd >= CONNS_CAPACITY || set_nonblocking(fd) < 0) {
+      fprintf(stderr, "[ERROR] - Too many connections\n");
+      close(fd);
+      continue;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    Conn *c = calloc(1, sizeof(Conn));
+    if (!c) {
+      close(fd);
+      continue;
+    }
+    c->fd = fd;
+    c->id = NEXT_CONN_ID++;
+    CONNS[fd] = c;
+
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(EPOLL_FD, EPOLL_CTL_ADD, fd, &ev);
+  }
+}
+
+// ----------------------------------------
+
+static int open_listener(int port, const char *unix_path) {
+  int fd;
+
+  if (unix_path) {
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", unix_path);
+    unlink(unix_path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+      perror("[ERROR] - bind");
+      return -1;
+    }
+  } else {
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t) port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int one = 1;
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0) {
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+    if (fd < 0 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+      perror("[ERROR] - bind");
+      return -1;
+    }
+  }
+
+  if (listen(fd, SOMAXCONN) < 0 || set_nonblocking(fd) < 0) {
+    perror("[ERROR] - listen");
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  int port = SERVER_DEFAULT_PORT;
+  const char *unix_path = NULL;
+  SESSIONS_COUNT = SERVER_DEFAULT_SESSIONS;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "p:u:n:")) != -1) {
+    switch (opt) {
+    case 'p': port = atoi(optarg); break;
+    case 'u': unix_path = optarg; break;
+    case 'n': SESSIONS_COUNT = atoi(optarg); break;
+    default:
+      fprintf(stderr, "Usage: %s [-p port | -u socket_path] [-n max_sessions]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (SESSIONS_COUNT < 1) {
+    fprintf(stderr, "[ERROR] - max sessions must be positive\n");
+    return 1;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  CONNS_CAPACITY = (int) sysconf(_SC_OPEN_MAX);
+  if (CONNS_CAPACITY <= 0) {
+    CONNS_CAPACITY = 1024;
+  }
+
+  SESSIONS = calloc(SESSIONS_COUNT, sizeof(ServerSession));
+  FREE_SESSIONS = malloc(SESSIONS_COUNT * sizeof(int));
+  CONNS = calloc(CONNS_CAPACITY, sizeof(Conn *));
+  if (!SESSIONS || !FREE_SESSIONS || !CONNS) {
+    fprintf(stderr, "[ERROR] - Could not allocate %d sessions\n", SESSIONS_COUNT);
+    return 1;
+  }
+
+  // lowest ids are handed out first
+  for (int i = 0; i < SESSIONS_COUNT; i++) {
+    FREE_SESSIONS[i] = SESSIONS_COUNT - 1 - i;
+  }
+  FREE_SESSIONS_COUNT = SESSIONS_COUNT;
+
+  int listen_fd = open_listener(port, unix_path);
+  EPOLL_FD = epoll_create1(0);
+  if (listen_fd < 0 || EPOLL_FD < 0) {
+    return 1;
+  }
+
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN;
+  ev.data.fd = listen_fd;
+  epoll_ctl(EPOLL_FD, EPOLL_CTL_ADD, listen_fd, &ev);
+
+  if (unix_path) {
+    printf("Listening on %s (%d sessions)\n", unix_path, SESSIONS_COUNT);
+  } else {
+    printf("Listening on 127.0.0.1:%d (%d sessions)\n", port, SESSIONS_COUNT);
+  }
+  fflush(stdout);
+
+  struct epoll_event events[MAX_EVENTS];
+
+  while (!QUIT) {
+    int n = epoll_wait(EPOLL_FD, events, MAX_EVENTS, -1);
+    if (n < 0) {
+      if (errno == EINTR) {
+	continue;
+      }
+      perror("[ERROR] - epoll_wait");
+      break;
+    }
+
+    for (int i = 0; i < n; i++) {
+      int fd = events[i].data.fd;
+
+      if (fd == listen_fd) {
+	accept_conns(listen_fd);
+	continue;
+      }
+
+      Conn *c = fd < CONNS_CAPACITY ? CONNS[fd] : NULL;
+      if (!c) {
+	continue;
+      }
+
+      if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) {
+	close_conn(c);
+	continue;
+      }
+
+      if (events[i].events & EPOLLOUT) {
+	if (!flush_conn(c)) {
+	  continue;
+	}
+      }
+
+      if (events[i].events & EPOLLIN) {
+	handle_input(c);
+      }
+    }
+  }
+
+  printf("Shutting down after %ld moves\n", MOVES_PLAYED);
+
+  for (int fd = 0; fd < CONNS_CAPACITY; fd++) {
+    if (CONNS[fd]) {
+      close_conn(CONNS[fd]);
+    }
+  }
+  for (int i = 0; i < SESSIONS_COUNT; i++) {
+    if (SESSIONS[i].initialized) {
+      session_destroy(&SESSIONS[i].session);
+    }
+  }
+
+  close(listen_fd);
+  close(EPOLL_FD);
+  if (unix_path) {
+    unlink(unix_path);
+  }
+
+  free(SESSIONS);
+  free(FREE_SESSIONS);
+  free(CONNS);
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "./include/game.h"
+#include "./include/arena.h"
+#include "./include/record.h"
+#include "./include/session.h"
+
+// ----------------------------------------
+// FUNCTIONS
+
+// Memory needed by a single session, including alignment padding.
+size_t session_footprint(void) {
+  return sizeof(Game) + SESSION_HISTORY_CAPACITY * sizeof(PackedMove) +
+    MAX_MOVES * sizeof(Move) + 3 * ARENA_ALIGNMENT;
+}
+
+// Carves the buffers of the session out of its arena. Since the arena
+// is sized by session_footprint() this can never fail.
+static void carve_session(Session *s) {
+  s->game = arena_alloc(&s->arena, sizeof(Game));
+  s->history = arena_alloc(&s->arena, SESSION_HISTORY_CAPACITY * sizeof(PackedMove));
+  s->moves = arena_alloc(&s->arena, MAX_MOVES * sizeof(Move));
+  assert(s->game && s->history && s->moves && "session arena is too small!");
+
+  s->history_count = 0;
+  s->moves_count = 0;
+
+  init_game(s->game);
+}
+
+int session_init(Session *s) {
+  if (!arena_init(&s->arena, session_footprint())) {
+    return 0;
+  }
+
+  carve_session(s);
+  return 1;
+}
+
+// Starts a new game within the same memory.
+void session_reset(Session *s) {
+  arena_reset(&s->arena);
+  carve_session(s);
+}
+
+void session_destroy(Session *s) {
+  arena_destroy(&s->arena);
+  s->game = NULL;
+  s->history = NULL;
+  s->moves = NULL;
+}
+
+// Plays the move `m` for the selected player.
+//
+// Returns SESSION_ILLEGAL_MOVE if the move is not valid,
+// SESSION_HISTORY_FULL if no more moves can be recorded, 1 if the move
+// ended the game and 0 otherwise.
+int session_play(Session *s, Move m) {
+  Game *game = s->game;
+
+  if (!validate_move(game, m)) {
+    return SESSION_ILLEGAL_MOVE;
+  }
+  if (s->history_count >= SESSION_HISTORY_CAPACITY) {
+    return SESSION_HISTORY_FULL;
+  }
+
+  s->history[s->history_count++] = pack_move(m.start, m.end);
+  s->moves_count = 0;
+
+  return move_piece(game, game->board[m.start.x][m.start.y], m.end);
+}
+
+void session_update_moves(Session *s) {
+  s->moves_count = generate_moves(s->game, s->moves, MAX_MOVES);
+}
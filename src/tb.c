@@ -0,0 +1,311 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "./include/game.h"
+#include "./include/tb.h"
+
+_Static_assert(sizeof(TbFileHeader) == 32, "TbFileHeader must be 32 bytes");
+
+typedef struct {
+  char name[TB_NAME_LEN];
+
+  // NULL if the file could not be found.
+  const uint8_t *base;
+  size_t size;
+} TbTable;
+
+// ----------------------------------------
+// GLOBAL VARIABLES
+
+TbStats TB_STATS = {0};
+
+static char *TB_PATH = NULL;
+
+static TbTable TABLES[TB_MAX_TABLES];
+static int TABLES_COUNT = 0;
+
+// piece kind of PieceType (t % 6), as used in table names.
+static const char KIND_CHARS[] = "KQRBNP";
+
+// ----------------------------------------
+// FUNCTIONS
+
+// `path` is a list of directories separated by ':'. Tables are looked
+// up in order, the first file found is the one being used.
+void tb_init(const char *path) {
+  tb_free();
+  memset(&TB_STATS, 0, sizeof(TB_STATS));
+  TB_PATH = strdup(path);
+}
+
+void tb_free(void) {
+  for (int i = 0; i < TABLES_COUNT; i++) {
+    if (TABLES[i].base) {
+      munmap((void *) TABLES[i].base, TABLES[i].size);
+    }
+  }
+
+  TABLES_COUNT = 0;
+  TB_STATS.tables_mapped = 0;
+
+  free(TB_PATH);
+  TB_PATH = NULL;
+}
+
+// Computes name and index of the position in `game`. With `mirror`
+// set, colors are swapped and the board is flipped vertically, which
+// gives the same position seen from the other side.
+//
+// Returns 0 if the position cannot be stored in a table.
+int tb_compute_key(const Game *game, int mirror, TbKey *key) {
+  // squares grouped by color (0 is white) and kind
+  int squares[2][6][TB_MAX_PIECES];
+  int counts[2][6] = {0};
+  int total = 0;
+
+  for (int y = 0; y < BOARD_HEIGHT; y++) {
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+      const Piece *p = game->board[x][y];
+      if (!p) {
+	continue;
+      }
+
+      if (++total > TB_MAX_PIECES) {
+	return 0;
+      }
+
+      int color = (IS_PIECE_WHITE(p->type) != mirror) ? 0 : 1;
+      int kind = p->type % 6;
+      int sq = (mirror ? BOARD_HEIGHT - 1 - y : y) * BOARD_WIDTH + x;
+      squares[color][kind][counts[color][kind]++] = sq;
+    }
+  }
+
+  if (counts[0][0] != 1 || counts[1][0] != 1) {
+    return 0;
+  }
+
+  int len = 0;
+  size_t index = 0, multiplier = 1;
+
+  for (int color = 0; color < 2; color++) {
+    if (color) {
+      key->name[len++] = 'v';
+    }
+
+    for (int kind = 0; kind < 6; kind++) {
+      for (int i = 0; i < counts[color][kind]; i++) {
+	key->name[len++] = KIND_CHARS[kind];
+	index += squares[color][kind][i] * multiplier;
+	multiplier *= BOARD_WIDTH * BOARD_HEIGHT;
+      }
+    }
+  }
+  key->name[len] = '\0';
+
+  if (IS_PLAYER_WHITE(game) != mirror) {
+    index += multiplier;
+  }
+
+  key->index = index;
+  key->pieces_count = total;
+
+  return 1;
+}
+
+static size_t table_size(int pieces_count) {
+  size_t size = 2;
+  for (int i = 0; i < pieces_count; i++) {
+    size *= BOARD_WIDTH * BOARD_HEIGHT;
+  }
+  return sizeof(TbFileHeader) + size;
+}
+
+static void map_table(TbTable *t) {
+  int pieces_count = (int) strlen(t->name) - 1;
+  char *dirs = strdup(TB_PATH);
+
+  for (char *dir = strtok(dirs, ":"); dir; dir = strtok(NULL, ":")) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s%s", dir, t->name, TB_EXTENSION);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      continue;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size != table_size(pieces_count)) {
+      fprintf(stderr, "[ERROR] - %s has an invalid size\n", path);
+      close(fd);
+      continue;
+    }
+
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+      fprintf(stderr, "[ERROR] - Could not map %s\n", path);
+      continue;
+    }
+
+    const TbFileHeader *h = base;
+    if (memcmp(h->magic, TB_MAGIC, sizeof(h->magic)) || h->version != TB_VERSION ||
+	h->pieces_count != pieces_count || strncmp(h->name, t->name, TB_NAME_LEN)) {
+      fprintf(stderr, "[ERROR] - %s has an invalid header\n", path);
+      munmap(base, st.st_size);
+      continue;
+    }
+
+    madvise(base, st.st_size, MADV_RANDOM);
+    t->base = base;
+    t->size = st.st_size;
+    TB_STATS.tables_mapped++;
+    break;
+  }
+
+  free(dirs);
+}
+
+// Returns the table called `name`, mapping it on first use, or NULL
+// if no such file exists.
+static const TbTable *lookup_table(const char *name) {
+  for (int i = 0; i < TABLES_COUNT; i++) {
+    if (!strcmp(TABLES[i].name, name)) {
+      return TABLES[i].base ? &TABLES[i] : NULL;
+    }
+  }
+
+  if (!TB_PATH || TABLES_COUNT >= TB_MAX_TABLES) {
+    return NULL;
+  }
+
+  TbTable *t = &TABLES[TABLES_COUNT++];
+  memset(t, 0, sizeof(*t));
+  snprintf(t->name, sizeof(t->name), "%s", name);
+  map_table(t);
+
+  return t->base ? t : NULL;
+}
+
+// Reads the raw entry of the position in `game`, see TB_VALUE_*.
+//
+// Returns 1 on a hit, 0 if no table covers the position and -1 if the
+// position cannot be stored in a table at all (e.g. too many pieces).
+int tb_probe_value(const Game *game, uint8_t *value) {
+  if (!TB_PATH) {
+    return -1;
+  }
+
+  for (int mirror = 0; mirror < 2; mirror++) {
+    TbKey key;
+    if (!tb_compute_key(game, mirror, &key)) {
+      return -1;
+    }
+
+    const TbTable *t = lookup_table(key.name);
+    if (t) {
+      *value = t->base[sizeof(TbFileHeader) + key.index];
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// Win, draw or loss for the selected player, as used within search.
+TbWdl tb_probe_wdl(const Game *game) {
+  uint8_t v;
+
+  int hit = tb_probe_value(game, &v);
+  if (hit < 0) {
+    return TB_FAILED;
+  }
+
+  TB_STATS.wdl_probes++;
+  if (!hit) {
+    return TB_FAILED;
+  }
+  TB_STATS.wdl_hits++;
+
+  return TB_VALUE_IS_WIN(v) ? TB_WIN : TB_VALUE_IS_LOSS(v) ? TB_LOSS : TB_DRAW;
+}
+
+// Picks the move of the selected player by looking at the entries of
+// every position reachable in one move: the fastest win, otherwise a
+// draw, otherwise the slowest loss. `distance` is the number of plies
+// until a king is eaten.
+//
+// Returns 1 on a hit, 0 if the position or any of its successors is
+// not covered by the available tables.
+int tb_probe_root(Game *game, Move *out, TbWdl *wdl, int *distance) {
+  uint8_t v;
+
+  int hit = tb_probe_value(game, &v);
+  if (hit < 0) {
+    return 0;
+  }
+
+  TB_STATS.root_probes++;
+  if (!hit) {
+    return 0;
+  }
+
+  Move moves[MAX_MOVES];
+  int count = generate_moves(game, moves, MAX_MOVES);
+  int best_rank = -TB_MAX_DISTANCE - 2;
+
+  for (int i = 0; i < count; i++) {
+    Piece *eating_piece = game->board[moves[i].end.x][moves[i].end.y];
+    int rank;
+
+    if (eating_piece && (eating_piece->type == B_KING || eating_piece->type == W_KING)) {
+      // eating the king wins in one ply
+      rank = TB_MAX_DISTANCE;
+    } else {
+      Undo u;
+      make_move(game, moves[i], &u);
+      hit = tb_probe_value(game, &v);
+      unmake_move(game, &u);
+
+      if (hit <= 0) {
+	return 0;
+      }
+
+      // entries are seen from the side of the opponent
+      int d = TB_VALUE_DISTANCE(v) + 1;
+      rank = TB_VALUE_IS_LOSS(v) ? TB_MAX_DISTANCE + 1 - d : TB_VALUE_IS_WIN(v) ? -TB_MAX_DISTANCE - 1 + d : 0;
+    }
+
+    if (rank > best_rank) {
+      best_rank = rank;
+      *out = moves[i];
+    }
+  }
+
+  if (count == 0) {
+    return 0;
+  }
+
+  if (best_rank > 0) {
+    *wdl = TB_WIN;
+    *distance = TB_MAX_DISTANCE + 1 - best_rank;
+  } else if (best_rank < 0) {
+    *wdl = TB_LOSS;
+    *distance = best_rank + TB_MAX_DISTANCE + 1;
+  } else {
+    *wdl = TB_DRAW;
+    *distance = 0;
+  }
+
+  TB_STATS.root_hits++;
+  return 1;
+}
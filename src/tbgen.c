@@ -0,0 +1,302 @@
+/*
+  Generates endgame tables by retrograde analysis.
+
+    ./tbgen [-o dir] KQvK KRvK ...
+
+  With no material given, every table with up to three pieces is
+  generated. Tables reached through a capture (e.g. KvK for KQvK) are
+  generated first when missing. See include/tb.h for the file format.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "./include/game.h"
+#include "./include/tb.h"
+
+#define SQUARE_COUNT (BOARD_WIDTH * BOARD_HEIGHT)
+
+// ----------------------------------------
+
+static const char *OUT_DIR = ".";
+
+static int valid_name(const char *name) {
+  const char *v = strchr(name, 'v');
+  size_t len = strlen(name);
+
+  if (!v || name[0] != 'K' || v[1] != 'K' || len - 1 > TB_MAX_PIECES || len >= TB_NAME_LEN) {
+    return 0;
+  }
+
+  // pieces of each side must follow the order used by tb_compute_key()
+  const char *kinds = "KQRBNP";
+  for (const char *c = name + 1; *c; c++) {
+    if (c == v || c == v + 1) {
+      continue;
+    }
+    if (!strchr(kinds + 1, *c) || (c[-1] != 'v' && strchr(kinds, c[-1]) > strchr(kinds, *c))) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int table_exists(const char *name) {
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/%s%s", OUT_DIR, name, TB_EXTENSION);
+  return access(path, F_OK) == 0;
+}
+
+// Name of the same material with colors swapped, e.g. KvKQ for KQvK.
+static void mirror_name(const char *name, char *out) {
+  const char *v = strchr(name, 'v');
+  sprintf(out, "%sv%.*s", v + 1, (int) (v - name), name);
+}
+
+static PieceType char2type(char c, int white) {
+  const char *kinds = "KQRBNP";
+  return (PieceType) ((strchr(kinds, c) - kinds) + (white ? W_KING : B_KING));
+}
+
+// Places the pieces of `name` on the squares encoded by `index`.
+//
+// Returns 0 if two pieces would share the same square.
+static int setup_position(Game *game, const char *name, size_t index) {
+  memset(game->board, 0, sizeof(game->board));
+
+  int white = 1, n = 0;
+  for (const char *c = name; *c; c++) {
+    if (*c == 'v') {
+      white = 0;
+      continue;
+    }
+
+    int sq = (int) (index % SQUARE_COUNT);
+    index /= SQUARE_COUNT;
+
+    Pos pos = {sq % BOARD_WIDTH, sq / BOARD_WIDTH};
+    if (game->board[pos.x][pos.y]) {
+      return 0;
+    }
+
+    game->pieces[n] = (Piece) {.type = char2type(*c, white), .pos = pos};
+    game->board[pos.x][pos.y] = &game->pieces[n++];
+  }
+
+  game->pieces_count = n;
+
+  game->selected_player = index ? &game->w_player : &game->b_player;
+  return 1;
+}
+
+static int generate(const char *name);
+
+// Generates the tables reachable from `name` by capturing a piece.
+static int generate_dependencies(const char *name) {
+  for (size_t i = 0; name[i]; i++) {
+    if (name[i] == 'K' || name[i] == 'v') {
+      continue;
+    }
+
+    char sub[TB_NAME_LEN];
+    snprintf(sub, sizeof(sub), "%.*s%s", (int) i, name, name + i + 1);
+    if (!generate(sub)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int write_table(const char *name, const uint8_t *values, size_t count) {
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/%s%s", OUT_DIR, name, TB_EXTENSION);
+
+  FILE *fp = fopen(path, "wb");
+  if (!fp) {
+    fprintf(stderr, "[ERROR] - Could not open %s for writing\n", path);
+    return 0;
+  }
+
+  TbFileHeader h = {0};
+  memcpy(h.magic, TB_MAGIC, sizeof(h.magic));
+  h.version = TB_VERSION;
+  h.pieces_count = (uint16_t) (strlen(name) - 1);
+  snprintf(h.name, sizeof(h.name), "%s", name);
+
+  int ok = fwrite(&h, sizeof(h), 1, fp) == 1 && fwrite(values, 1, count, fp) == count;
+  ok = (fclose(fp) == 0) && ok;
+
+  if (!ok) {
+    fprintf(stderr, "[ERROR] - Could not write %s\n", path);
+  }
+  return ok;
+}
+
+// Iteration k decides every position that is won or lost in exactly
+// k plies: it is won if some move leads to a position lost in less
+// than k plies, and lost if every move leads to a position won in
+// less than k plies. Positions never decided are draws.
+static int generate(const char *name) {
+  char mirrored[TB_NAME_LEN];
+  mirror_name(name, mirrored);
+
+  if (table_exists(name) || table_exists(mirrored)) {
+    return 1;
+  }
+
+  if (!generate_dependencies(name)) {
+    return 0;
+  }
+
+  int pieces_count = (int) strlen(name) - 1;
+  size_t count = 2;
+  for (int i = 0; i < pieces_count; i++) {
+    count *= SQUARE_COUNT;
+  }
+
+  uint8_t *values = calloc(count, 1);
+  uint8_t *decided = calloc(count, 1);
+  if (!values || !decided) {
+    fprintf(stderr, "[ERROR] - Could not allocate %s\n", name);
+    free(values);
+    free(decided);
+    return 0;
+  }
+
+  Game game = {0};
+  Move moves[MAX_MOVES];
+
+  // subtables can hold wins and losses longer than anything found so
+  // far in this table, keep iterating until those are taken in account.
+  int max_sub_distance = 0;
+
+  printf("Generating %s ...", name);
+  fflush(stdout);
+
+  int k = 1, changed = 1;
+  for (; changed || k <= max_sub_distance + 1; k++) {
+    if (k > TB_MAX_DISTANCE) {
+      fprintf(stderr, "\n[ERROR] - %s needs more than %d plies\n", name, TB_MAX_DISTANCE);
+      free(values);
+      free(decided);
+      return 0;
+    }
+
+    changed = 0;
+
+    for (size_t idx = 0; idx < count; idx++) {
+      if (decided[idx] || !setup_position(&game, name, idx)) {
+	continue;
+      }
+
+      int moves_count = generate_moves(&game, moves, MAX_MOVES);
+      int win = 0, all_won = moves_count > 0, max_won = 0;
+
+      for (int i = 0; i < moves_count && !win; i++) {
+	Piece *eating_piece = game.board[moves[i].end.x][moves[i].end.y];
+	if (eating_piece && (eating_piece->type == B_KING || eating_piece->type == W_KING)) {
+	  win = 1;
+	  break;
+	}
+
+	Undo u;
+	uint8_t v = TB_VALUE_DRAW;
+	int known = 0;
+
+	make_move(&game, moves[i], &u);
+	if (u.captured) {
+	  if (tb_probe_value(&game, &v) != 1) {
+	    fprintf(stderr, "\n[ERROR] - Missing subtable for %s\n", name);
+	    exit(1);
+	  }
+	  known = 1;
+	  if (TB_VALUE_DISTANCE(v) > max_sub_distance) {
+	    max_sub_distance = TB_VALUE_DISTANCE(v);
+	  }
+	} else {
+	  TbKey key;
+	  tb_compute_key(&game, 0, &key);
+	  v = values[key.index];
+	  known = decided[key.index] && TB_VALUE_DISTANCE(v) < k;
+	}
+	unmake_move(&game, &u);
+
+	if (known && TB_VALUE_IS_LOSS(v) && TB_VALUE_DISTANCE(v) < k) {
+	  win = TB_VALUE_DISTANCE(v) + 1;
+	} else if (known && TB_VALUE_IS_WIN(v) && TB_VALUE_DISTANCE(v) < k) {
+	  if (TB_VALUE_DISTANCE(v) > max_won) {
+	    max_won = TB_VALUE_DISTANCE(v);
+	  }
+	} else {
+	  all_won = 0;
+	}
+      }
+
+      if (win) {
+	values[idx] = TB_VALUE_WIN(win);
+      } else if (all_won) {
+	values[idx] = TB_VALUE_LOSS(max_won + 1);
+      } else {
+	continue;
+      }
+
+      decided[idx] = 1;
+      changed = 1;
+    }
+  }
+
+  int max_distance = 0;
+  for (size_t idx = 0; idx < count; idx++) {
+    if (TB_VALUE_DISTANCE(values[idx]) > max_distance) {
+      max_distance = TB_VALUE_DISTANCE(values[idx]);
+    }
+  }
+  printf(" done (longest win in %d plies)\n", max_distance);
+
+  int ok = write_table(name, values, count);
+  free(values);
+  free(decided);
+
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  static const char *DEFAULT_TABLES[] = {"KvK", "KQvK", "KRvK", "KBvK", "KNvK", "KPvK"};
+
+  int opt;
+  while ((opt = getopt(argc, argv, "o:")) != -1) {
+    switch (opt) {
+    case 'o': OUT_DIR = optarg; break;
+    default:
+      fprintf(stderr, "Usage: %s [-o dir] [material ...]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // subtables are read back through the regular probing code
+  tb_init(OUT_DIR);
+
+  int ok = 1;
+  if (optind == argc) {
+    for (size_t i = 0; i < sizeof(DEFAULT_TABLES) / sizeof(DEFAULT_TABLES[0]) && ok; i++) {
+      ok = generate(DEFAULT_TABLES[i]);
+    }
+  }
+
+  for (int i = optind; i < argc && ok; i++) {
+    if (!valid_name(argv[i])) {
+      fprintf(stderr, "[ERROR] - Invalid material %s (at most %d pieces, e.g. KQvK)\n", argv[i], TB_MAX_PIECES);
+      return 1;
+    }
+    ok = generate(argv[i]);
+  }
+
+  tb_free();
+  return ok ? 0 : 1;
+}